@@ -0,0 +1,435 @@
+#pragma once
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <algorithm>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// ----------------- AgendaIndex -----------------
+// Events of an .ics file, sorted by start. Everything that starts at or
+// after t is one binary search away; what is still ongoing at t comes from
+// a max-of-end tree over the same order, which only descends into ranges
+// holding an event that has not ended. A query visits the events it
+// returns plus O(log n) nodes each, however many are over or long-running.
+//
+// The index is saved next to the source as `<source>.idx`. If size and
+// mtime still match, startup reads only that. After a change, the .ics is
+// streamed once and every VEVENT block is hashed. Blocks whose hash is
+// already in the old index reuse its event, and only new or edited blocks
+// are parsed.
+//
+// Supported: DTSTART/DTEND (UTC "Z", floating/TZID as local time, or
+// VALUE=DATE all-day), DURATION and SUMMARY. Recurrence rules are not
+// expanded; a recurring event appears at its first occurrence.
+//
+// No GLib: build() runs on the worker pool.
+//
+// File layout: AgendaIndexHeader, count AgendaIndexEntry, then string_bytes
+// of summaries (not NUL-terminated; entries hold offset and length).
+
+#pragma pack(push, 1)
+struct AgendaIndexHeader
+{
+    uint32_t magic; // 'DWAI'
+    uint16_t version;
+    uint16_t reserved;
+    int64_t source_mtime;
+    int64_t source_size;
+    uint32_t count;
+    uint32_t string_bytes;
+};
+
+struct AgendaIndexEntry
+{
+    int64_t start, end;  // unix seconds
+    uint64_t block_hash; // FNV-1a of the raw VEVENT block
+    uint32_t summary_off;
+    uint16_t summary_len;
+    uint8_t all_day;
+    uint8_t reserved;
+};
+#pragma pack(pop)
+
+struct AgendaEvent
+{
+    int64_t start, end;
+    uint64_t block_hash;
+    bool all_day;
+    std::string summary;
+};
+
+class AgendaIndex
+{
+public:
+    static constexpr uint32_t MAGIC = 0x49415744; // "DWAI"
+    static constexpr uint16_t VERSION = 1;
+
+    std::vector<AgendaEvent> events; // sorted by start
+    size_t reparsed = 0;             // blocks parsed by the last build()
+
+    // Load `<source>.idx` if it matches the source, else rebuild from the
+    // .ics (reusing `previous` blocks) and save. False if the source is
+    // unreadable.
+    bool build(const std::string &source, const AgendaIndex *previous = nullptr)
+    {
+        struct stat st;
+        if (stat(source.c_str(), &st) < 0)
+            return false;
+        std::string index_path = source + ".idx";
+
+        if (!previous && load(index_path, st))
+            return true;
+
+        std::unordered_map<uint64_t, const AgendaEvent *> known;
+        AgendaIndex cached;
+        if (!previous && cached.load(index_path, st, false))
+            previous = &cached;
+        if (previous)
+        {
+            for (auto &e : previous->events)
+                known[e.block_hash] = &e;
+        }
+
+        if (!scan(source, known))
+            return false;
+        finish();
+        save(index_path, st);
+        return true;
+    }
+
+    // First `n` events that have not ended at `now`, in start order
+    std::vector<const AgendaEvent *> upcoming(int64_t now, size_t n) const
+    {
+        std::vector<const AgendaEvent *> out;
+        // Started before now: only those still running
+        size_t later = std::lower_bound(events.begin(), events.end(), now,
+                                        [](const AgendaEvent &e, int64_t t) { return e.start < t; }) -
+                       events.begin();
+        for (size_t i = first_running(0, now); i < later && out.size() < n; i = first_running(i + 1, now))
+            out.push_back(&events[i]);
+        // Starting now or later: all of them, in order
+        for (size_t i = later; i < events.size() && out.size() < n; i++)
+            out.push_back(&events[i]);
+        return out;
+    }
+
+    // Next time after `now` at which upcoming(now, n) changes, or 0 if never
+    int64_t next_change(int64_t now, size_t n) const
+    {
+        std::vector<const AgendaEvent *> shown = upcoming(now, n);
+        int64_t next = 0;
+        auto consider = [&](int64_t t) {
+            if (t > now && (next == 0 || t < next))
+                next = t;
+        };
+        for (auto *e : shown)
+        {
+            consider(e->start); // moves from "next" to "now"
+            consider(e->end);   // drops off
+        }
+        // A list that is not full yet cannot gain entries as time passes; a
+        // full one only changes when an entry ends (covered above)
+        return next;
+    }
+
+private:
+    // Implicit binary tree over events: end_tree[leaves + i] = events[i].end,
+    // each inner node the max of its two children
+    std::vector<int64_t> end_tree;
+    size_t leaves = 0;
+
+    static uint64_t fnv(const std::string &s, uint64_t h = 1469598103934665603ULL)
+    {
+        for (unsigned char c : s)
+            h = (h ^ c) * 1099511628211ULL;
+        return h;
+    }
+
+    void finish()
+    {
+        std::sort(events.begin(), events.end(),
+                  [](const AgendaEvent &a, const AgendaEvent &b) { return a.start < b.start; });
+        leaves = 1;
+        while (leaves < events.size())
+            leaves *= 2;
+        end_tree.assign(2 * leaves, INT64_MIN);
+        for (size_t i = 0; i < events.size(); i++)
+            end_tree[leaves + i] = events[i].end;
+        for (size_t k = leaves - 1; k > 0; k--)
+            end_tree[k] = std::max(end_tree[2 * k], end_tree[2 * k + 1]);
+    }
+
+    // Lowest index >= from whose event ends after `now`, or events.size()
+    size_t first_running(size_t from, int64_t now) const
+    {
+        size_t i = first_running(1, 0, leaves, from, now);
+        return std::min(i, events.size());
+    }
+
+    // Same, within the subtree `node` covering [lo, hi)
+    size_t first_running(size_t node, size_t lo, size_t hi, size_t from, int64_t now) const
+    {
+        if (hi <= from || end_tree[node] <= now)
+            return SIZE_MAX; // nothing running in here
+        if (hi - lo == 1)
+            return lo;
+        size_t mid = (lo + hi) / 2;
+        size_t i = first_running(2 * node, lo, mid, from, now);
+        return i != SIZE_MAX ? i : first_running(2 * node + 1, mid, hi, from, now);
+    }
+
+    // Stream the file line by line (unfolding continuation lines), hash each
+    // VEVENT block and parse only blocks not in `known`
+    bool scan(const std::string &source, const std::unordered_map<uint64_t, const AgendaEvent *> &known)
+    {
+        FILE *f = fopen(source.c_str(), "rb");
+        if (!f)
+            return false;
+
+        events.clear();
+        reparsed = 0;
+        std::vector<std::string> block;
+        bool in_event = false;
+        uint64_t hash = 0;
+        std::string line, pending;
+        char buf[1024];
+
+        auto handle_line = [&](const std::string &l) {
+            if (l == "BEGIN:VEVENT")
+            {
+                in_event = true;
+                block.clear();
+                hash = fnv(l);
+            }
+            else if (in_event && l == "END:VEVENT")
+            {
+                in_event = false;
+                auto it = known.find(hash);
+                if (it != known.end())
+                    events.push_back(*it->second);
+                else
+                {
+                    AgendaEvent e;
+                    reparsed++;
+                    if (parse_event(block, e))
+                    {
+                        e.block_hash = hash;
+                        events.push_back(e);
+                    }
+                }
+            }
+            else if (in_event)
+            {
+                block.push_back(l);
+                hash = fnv(l, fnv("\n", hash));
+            }
+        };
+
+        // Physical lines -> logical lines (RFC 5545 folding: a line starting
+        // with a space or tab continues the previous one)
+        bool have_pending = false;
+        while (fgets(buf, sizeof(buf), f))
+        {
+            line += buf;
+            if (line.empty() || line.back() != '\n')
+                continue; // longer than buf; keep reading
+            while (!line.empty() && (line.back() == '\n' || line.back() == '\r'))
+                line.pop_back();
+            if (!line.empty() && (line[0] == ' ' || line[0] == '\t') && have_pending)
+                pending += line.substr(1);
+            else
+            {
+                if (have_pending)
+                    handle_line(pending);
+                pending.swap(line);
+                have_pending = true;
+            }
+            line.clear();
+        }
+        if (!line.empty())
+        {
+            while (!line.empty() && line.back() == '\r')
+                line.pop_back();
+            if (have_pending)
+                handle_line(pending);
+            pending.swap(line);
+            have_pending = true;
+        }
+        if (have_pending)
+            handle_line(pending);
+        fclose(f);
+        return true;
+    }
+
+    static bool parse_event(const std::vector<std::string> &block, AgendaEvent &e)
+    {
+        bool have_start = false, have_end = false, start_date = false;
+        int64_t duration = -1;
+        e.start = e.end = 0;
+        e.all_day = false;
+        for (auto &l : block)
+        {
+            size_t colon = l.find(':');
+            if (colon == std::string::npos)
+                continue;
+            std::string name = l.substr(0, colon);
+            std::string params;
+            size_t semi = name.find(';');
+            if (semi != std::string::npos)
+            {
+                params = name.substr(semi);
+                name = name.substr(0, semi);
+            }
+            std::string value = l.substr(colon + 1);
+
+            if (name == "DTSTART")
+                have_start = parse_time(value, params, &e.start, &start_date);
+            else if (name == "DTEND")
+            {
+                bool date;
+                have_end = parse_time(value, params, &e.end, &date);
+            }
+            else if (name == "DURATION")
+                duration = parse_duration(value);
+            else if (name == "SUMMARY")
+                e.summary = unescape(value);
+        }
+        if (!have_start)
+            return false;
+        e.all_day = start_date;
+        if (!have_end)
+            e.end = e.start + (duration >= 0 ? duration : (start_date ? 86400 : 0));
+        return true;
+    }
+
+    // 20240115T090000Z (UTC), 20240115T090000 (local), 20240115 (date)
+    static bool parse_time(const std::string &v, const std::string &params, int64_t *out, bool *is_date)
+    {
+        struct tm t;
+        memset(&t, 0, sizeof(t));
+        if (v.size() < 8 || sscanf(v.c_str(), "%4d%2d%2d", &t.tm_year, &t.tm_mon, &t.tm_mday) != 3)
+            return false;
+        t.tm_year -= 1900;
+        t.tm_mon -= 1;
+        *is_date = v.size() == 8 || params.find("VALUE=DATE") != std::string::npos;
+        if (!*is_date && (v.size() < 15 || sscanf(v.c_str() + 9, "%2d%2d%2d", &t.tm_hour, &t.tm_min, &t.tm_sec) != 3))
+            return false;
+        if (!*is_date && v.back() == 'Z')
+            *out = timegm(&t);
+        else
+        {
+            t.tm_isdst = -1;
+            *out = mktime(&t);
+        }
+        return true;
+    }
+
+    // P1D, PT1H30M, P1W, ... (seconds; -1 if unparsable)
+    static int64_t parse_duration(const std::string &v)
+    {
+        int64_t total = 0, num = 0;
+        bool any = false;
+        for (char c : v)
+        {
+            if (c >= '0' && c <= '9')
+                num = num * 10 + (c - '0');
+            else
+            {
+                int64_t unit = c == 'W' ? 604800 : c == 'D' ? 86400 : c == 'H' ? 3600 : c == 'M' ? 60 : c == 'S' ? 1 : 0;
+                if (unit)
+                {
+                    total += num * unit;
+                    any = true;
+                }
+                num = 0;
+            }
+        }
+        return any ? total : -1;
+    }
+
+    static std::string unescape(const std::string &v)
+    {
+        std::string out;
+        for (size_t i = 0; i < v.size(); i++)
+        {
+            if (v[i] == '\\' && i + 1 < v.size())
+            {
+                char c = v[++i];
+                out += (c == 'n' || c == 'N') ? ' ' : c;
+            }
+            else
+                out += v[i];
+        }
+        return out;
+    }
+
+    // ---------------- Persistence ----------------
+    bool load(const std::string &path, const struct stat &source, bool require_match = true)
+    {
+        FILE *f = fopen(path.c_str(), "rb");
+        if (!f)
+            return false;
+        AgendaIndexHeader h;
+        bool ok = fread(&h, sizeof(h), 1, f) == 1 && h.magic == MAGIC && h.version == VERSION &&
+                  h.count < (1u << 24) && h.string_bytes < (1u << 28);
+        if (ok && require_match)
+            ok = h.source_mtime == (int64_t)source.st_mtime && h.source_size == (int64_t)source.st_size;
+
+        std::vector<AgendaIndexEntry> entries;
+        std::string strings;
+        if (ok)
+        {
+            entries.resize(h.count);
+            strings.resize(h.string_bytes);
+            ok = (h.count == 0 || fread(entries.data(), sizeof(AgendaIndexEntry), h.count, f) == h.count) &&
+                 (h.string_bytes == 0 || fread(&strings[0], h.string_bytes, 1, f) == 1);
+        }
+        fclose(f);
+        if (!ok)
+            return false;
+
+        events.clear();
+        for (auto &en : entries)
+        {
+            if ((size_t)en.summary_off + en.summary_len > strings.size())
+                return false;
+            events.push_back({en.start, en.end, en.block_hash, en.all_day != 0,
+                              strings.substr(en.summary_off, en.summary_len)});
+        }
+        reparsed = 0;
+        finish();
+        return true;
+    }
+
+    void save(const std::string &path, const struct stat &source) const
+    {
+        std::vector<AgendaIndexEntry> entries;
+        std::string strings;
+        for (auto &e : events)
+        {
+            size_t len = std::min<size_t>(e.summary.size(), 0xFFFF);
+            entries.push_back({e.start, e.end, e.block_hash, static_cast<uint32_t>(strings.size()),
+                               static_cast<uint16_t>(len), static_cast<uint8_t>(e.all_day), 0});
+            strings.append(e.summary, 0, len);
+        }
+        AgendaIndexHeader h{MAGIC, VERSION, 0, (int64_t)source.st_mtime, (int64_t)source.st_size,
+                            static_cast<uint32_t>(entries.size()), static_cast<uint32_t>(strings.size())};
+
+        std::string tmp = path + ".tmp";
+        FILE *f = fopen(tmp.c_str(), "wb");
+        if (!f)
+            return;
+        bool ok = fwrite(&h, sizeof(h), 1, f) == 1 &&
+                  (entries.empty() || fwrite(entries.data(), sizeof(AgendaIndexEntry), entries.size(), f) == entries.size()) &&
+                  (strings.empty() || fwrite(strings.data(), strings.size(), 1, f) == 1);
+        ok = (fclose(f) == 0) && ok;
+        if (!ok || rename(tmp.c_str(), path.c_str()) != 0)
+            unlink(tmp.c_str());
+    }
+};
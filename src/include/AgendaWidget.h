@@ -0,0 +1,191 @@
+#pragma once
+#include <gtk/gtk.h>
+#include <time.h>
+#include <memory>
+#include <string>
+#include "ModularWidget.h"
+#include "TextStyle.h"
+#include "AgendaIndex.h"
+#include "DataSource.h"
+#include "DataDir.h"
+#include "BinLog.h"
+
+// Next `count` events from an .ics file. The index is (re)built on the
+// worker pool whenever the file changes; between changes the widget sleeps
+// until the moment the shown list changes (an event starts or ends), which
+// the index computes. No periodic timer.
+class AgendaWidget : public ModularWidget
+{
+public:
+    std::string ics_path;
+    int count;
+
+    AgendaWidget(int col_, int row_,
+                 int width_blocks_, int height_blocks_,
+                 const std::string &ics_path_, int count_ = 5,
+                 int total_blocks_x_ = 4, int total_blocks_y_ = 4)
+        : ModularWidget(col_, row_, width_blocks_, height_blocks_,
+                        total_blocks_x_, total_blocks_y_),
+          ics_path(ics_path_), count(std::max(1, std::min(20, count_)))
+    {
+        gtkWidget = gtk_frame_new(NULL);
+        list_label = gtk_label_new(NULL);
+        gtk_misc_set_alignment(GTK_MISC(list_label), 0.0, 0.0);
+        gtk_misc_set_padding(GTK_MISC(list_label), 6, 6);
+        gtk_label_set_ellipsize(GTK_LABEL(list_label), PANGO_ELLIPSIZE_END);
+        agenda_style().apply(list_label);
+        gtk_container_add(GTK_CONTAINER(gtkWidget), list_label);
+        gtk_widget_show_all(gtkWidget);
+
+        // The first notification (right after binding) loads the index
+        DataSources::get().watch(ics_path.c_str(), this);
+
+        initialize();
+    }
+
+    ~AgendaWidget()
+    {
+        if (timer_id > 0) remove_timer(timer_id);
+    }
+
+    const char *type_name() const override { return "AgendaWidget"; }
+
+    uint64_t state_hash() const override
+    {
+        const char *shown = gtk_label_get_text(GTK_LABEL(list_label));
+        return hash_bytes(shown, strlen(shown));
+    }
+
+    void on_data(const char *const *keys, const char *const *values, int n) override
+    {
+        for (int i = 0; i < n; i++)
+        {
+            if (strcmp(keys[i], "changed") == 0)
+                reindex();
+        }
+    }
+
+    void on_resume() override
+    {
+        refresh();
+    }
+
+    void on_display_off() override
+    {
+        stop_timer(timer_id);
+    }
+
+private:
+    GtkWidget *list_label;
+    guint timer_id = 0;
+    std::shared_ptr<const AgendaIndex> index;
+    bool indexing = false, reindex_again = false;
+
+    // Rebuild on a worker; the current index supplies unchanged events
+    void reindex()
+    {
+        if (indexing)
+        {
+            reindex_again = true;
+            return;
+        }
+        indexing = true;
+        submit_work(index_static, indexed_static, new IndexJob{this, ics_path, index, nullptr}, free_job_static);
+    }
+
+    // Worker side of reindex(): the path and previous index are its own
+    struct IndexJob
+    {
+        AgendaWidget *self;
+        std::string path;
+        std::shared_ptr<const AgendaIndex> previous, built;
+    };
+
+    static void index_static(gpointer data)
+    {
+        auto *job = static_cast<IndexJob *>(data);
+        auto built = std::make_shared<AgendaIndex>();
+        if (built->build(job->path, job->previous.get()))
+            job->built = built;
+    }
+
+    static void indexed_static(gpointer data)
+    {
+        auto *job = static_cast<IndexJob *>(data);
+        job->self->on_indexed(job->built);
+    }
+
+    static void free_job_static(gpointer data)
+    {
+        delete static_cast<IndexJob *>(data);
+    }
+
+    void on_indexed(const std::shared_ptr<const AgendaIndex> &built)
+    {
+        indexing = false;
+        if (built)
+        {
+            BINLOG("[AGENDA] %zu events, %zu block(s) parsed", built->events.size(), built->reparsed);
+            index = built;
+            refresh();
+        }
+        if (reindex_again)
+        {
+            reindex_again = false;
+            reindex();
+        }
+    }
+
+    // Show the list for now and sleep until it next changes
+    void refresh()
+    {
+        stop_timer(timer_id);
+        if (!index)
+            return;
+
+        time_t now = Clock::get()->wall_time();
+        std::string text;
+        for (const AgendaEvent *e : index->upcoming(now, count))
+        {
+            time_t start = static_cast<time_t>(e->start);
+            struct tm t;
+            localtime_r(&start, &t);
+            char when[32];
+            if (e->start <= now)
+                snprintf(when, sizeof(when), "now");
+            else if (e->all_day)
+                strftime(when, sizeof(when), "%a %d", &t);
+            else
+                strftime(when, sizeof(when), "%a %H:%M", &t);
+            if (!text.empty())
+                text += "\n";
+            text += std::string(when) + "  " + e->summary;
+        }
+        if (text.empty())
+            text = "No upcoming events";
+
+        set_label_text(list_label, text.c_str());
+
+        int64_t next = index->next_change(now, count);
+        if (next > 0)
+        {
+            // One-shot; capped so a changed wall clock is noticed within a day
+            int64_t delay_s = std::min<int64_t>(next - now, 86400);
+            timer_id = add_timer(static_cast<guint>(delay_s * 1000), on_change_static, this);
+        }
+    }
+
+    static gboolean on_change_static(gpointer data)
+    {
+        auto *self = static_cast<AgendaWidget *>(data);
+        self->timer_id = 0;
+        self->refresh();
+        return FALSE;
+    }
+
+    static const TextStyle &agenda_style()
+    {
+        static const TextStyle style(11000);
+        return style;
+    }
+};
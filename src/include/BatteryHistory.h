@@ -0,0 +1,308 @@
+#pragma once
+#include <gtk/gtk.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <cmath>
+#include <algorithm>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "DataDir.h"
+
+// Kindle battery sysfs nodes, read by BatteryWidget and BatteryHistoryWidget
+// (adjust if needed for your specific model). K3/K4 often use mc13892_bat,
+// Paperwhites often use 'max77696-battery' or just 'battery'
+static const char *const BATTERY_CAPACITY_PATH = "/sys/class/power_supply/max77696-battery/capacity";
+static const char *const BATTERY_STATUS_PATH   = "/sys/class/power_supply/max77696-battery/status";
+
+// ----------------- BatteryHistory -----------------
+// Battery samples in a fixed-size file that is mmap'ed shared and updated in
+// place: constant memory and disk, survives restarts. Every sample goes to
+// the raw ring and is folded into the rollup rings, so older history is
+// still available at coarser resolution:
+//
+//   level 0: every sample (~1 min)  1440 points  ~1 day
+//   level 1: 15 min buckets          960 points  10 days
+//   level 2: 2 h buckets             720 points  60 days
+//
+// The open rollup buckets live in the header too, so a restart loses
+// nothing. query() stitches the levels into one time-ordered series and
+// lttb() reduces it to the pixel width of a graph.
+
+#pragma pack(push, 1)
+struct HistoryPoint
+{
+    uint32_t time; // unix seconds (bucket start for rollups)
+    uint8_t avg, min, max;
+    uint8_t charging; // share of samples taken while charging, 0..255
+};
+
+struct HistoryLevel
+{
+    uint32_t interval_s; // 0 for the raw level
+    uint32_t capacity;
+    uint32_t head;  // next slot to write
+    uint32_t count; // valid points
+    // Open bucket
+    uint32_t bucket_start;
+    uint32_t n, sum, charging_n;
+    uint8_t min, max;
+    uint16_t reserved;
+};
+
+struct HistoryFileHeader
+{
+    uint32_t magic; // 'DWBH'
+    uint16_t version;
+    uint16_t level_count;
+    HistoryLevel levels[3];
+};
+#pragma pack(pop)
+
+class BatteryHistory
+{
+public:
+    static constexpr uint32_t MAGIC = 0x48425744; // "DWBH"
+    static constexpr uint16_t VERSION = 1;
+    static constexpr int LEVELS = 3;
+    static constexpr uint32_t MIN_SPACING_S = 30; // drop samples closer than this
+
+    static BatteryHistory &get()
+    {
+        static BatteryHistory history(data_path("battery-history.bin"));
+        return history;
+    }
+
+    BatteryHistory(const std::string &path) : map(nullptr), map_size(0)
+    {
+        open_file(path);
+    }
+
+    ~BatteryHistory()
+    {
+        if (map)
+            munmap(map, map_size);
+    }
+
+    BatteryHistory(const BatteryHistory &) = delete;
+    BatteryHistory &operator=(const BatteryHistory &) = delete;
+
+    // Bumped by every stored sample; lets views skip recomputation
+    uint32_t generation = 0;
+
+    void record(time_t now, int percentage, bool charging)
+    {
+        if (!map)
+            return;
+        HistoryPoint last = latest();
+        if (last.time != 0 && (uint32_t)now < last.time + MIN_SPACING_S)
+            return;
+
+        uint8_t pct = static_cast<uint8_t>(std::max(0, std::min(100, percentage)));
+        push(0, {static_cast<uint32_t>(now), pct, pct, pct, static_cast<uint8_t>(charging ? 255 : 0)});
+
+        for (int l = 1; l < LEVELS; l++)
+        {
+            HistoryLevel &lv = header()->levels[l];
+            uint32_t bucket = static_cast<uint32_t>(now) / lv.interval_s * lv.interval_s;
+            if (lv.n > 0 && bucket != lv.bucket_start)
+                close_bucket(l);
+            if (lv.n == 0)
+            {
+                lv.bucket_start = bucket;
+                lv.min = pct;
+                lv.max = pct;
+            }
+            lv.n++;
+            lv.sum += pct;
+            lv.charging_n += charging;
+            lv.min = std::min(lv.min, pct);
+            lv.max = std::max(lv.max, pct);
+        }
+        generation++;
+    }
+
+    // Newest raw sample; time 0 if there is none
+    HistoryPoint latest() const
+    {
+        HistoryPoint none{0, 0, 0, 0, 0};
+        if (!map || header()->levels[0].count == 0)
+            return none;
+        const HistoryLevel &raw = header()->levels[0];
+        return ring(0)[(raw.head + raw.capacity - 1) % raw.capacity];
+    }
+
+    // Points with time >= from, oldest first, each span taken from the
+    // finest level that still covers it
+    std::vector<HistoryPoint> query(uint32_t from) const
+    {
+        std::vector<HistoryPoint> out;
+        if (!map)
+            return out;
+
+        uint32_t covered_from = UINT32_MAX; // start of what finer levels cover
+        std::vector<std::vector<HistoryPoint>> parts(LEVELS);
+        for (int l = 0; l < LEVELS; l++)
+        {
+            const HistoryLevel &lv = header()->levels[l];
+            uint32_t oldest = UINT32_MAX;
+            for (uint32_t i = 0; i < lv.count; i++)
+            {
+                const HistoryPoint &p = ring(l)[(lv.head + lv.capacity - lv.count + i) % lv.capacity];
+                oldest = std::min(oldest, p.time);
+                if (p.time >= from && p.time + std::max(lv.interval_s, 1u) <= covered_from)
+                    parts[l].push_back(p);
+            }
+            if (oldest != UINT32_MAX)
+                covered_from = std::min(covered_from, oldest);
+            if (covered_from <= from)
+                break;
+        }
+        for (int l = LEVELS - 1; l >= 0; l--)
+            out.insert(out.end(), parts[l].begin(), parts[l].end());
+        return out;
+    }
+
+    // Largest-Triangle-Three-Buckets: keep `threshold` points that preserve
+    // the visual shape (first and last always kept). O(points).
+    static std::vector<HistoryPoint> lttb(const std::vector<HistoryPoint> &data, size_t threshold)
+    {
+        if (threshold >= data.size() || threshold < 3)
+            return data;
+
+        std::vector<HistoryPoint> out;
+        out.reserve(threshold);
+        out.push_back(data.front());
+
+        double every = static_cast<double>(data.size() - 2) / (threshold - 2);
+        size_t a = 0;
+        for (size_t i = 0; i < threshold - 2; i++)
+        {
+            // Average of the next bucket
+            size_t next_start = static_cast<size_t>((i + 1) * every) + 1;
+            size_t next_end = std::min(static_cast<size_t>((i + 2) * every) + 1, data.size());
+            double avg_x = 0, avg_y = 0;
+            for (size_t j = next_start; j < next_end; j++)
+            {
+                avg_x += data[j].time;
+                avg_y += data[j].avg;
+            }
+            size_t next_len = next_end - next_start;
+            if (next_len > 0)
+            {
+                avg_x /= next_len;
+                avg_y /= next_len;
+            }
+
+            // Point of this bucket forming the largest triangle with a and avg
+            size_t start = static_cast<size_t>(i * every) + 1;
+            size_t end = static_cast<size_t>((i + 1) * every) + 1;
+            double ax = data[a].time, ay = data[a].avg;
+            double best_area = -1;
+            size_t best = start;
+            for (size_t j = start; j < end; j++)
+            {
+                double area = std::fabs((ax - avg_x) * (data[j].avg - ay) -
+                                        (ax - data[j].time) * (avg_y - ay));
+                if (area > best_area)
+                {
+                    best_area = area;
+                    best = j;
+                }
+            }
+            out.push_back(data[best]);
+            a = best;
+        }
+
+        out.push_back(data.back());
+        return out;
+    }
+
+private:
+    void *map;
+    size_t map_size;
+    HistoryPoint *rings[LEVELS] = {};
+
+    HistoryFileHeader *header() const { return static_cast<HistoryFileHeader *>(map); }
+    HistoryPoint *ring(int level) const { return rings[level]; }
+
+    void push(int level, const HistoryPoint &p)
+    {
+        HistoryLevel &lv = header()->levels[level];
+        ring(level)[lv.head] = p;
+        lv.head = (lv.head + 1) % lv.capacity;
+        lv.count = std::min(lv.count + 1, lv.capacity);
+    }
+
+    void close_bucket(int level)
+    {
+        HistoryLevel &lv = header()->levels[level];
+        push(level, {lv.bucket_start, static_cast<uint8_t>(lv.sum / lv.n), lv.min, lv.max,
+                     static_cast<uint8_t>(lv.charging_n * 255 / lv.n)});
+        lv.n = lv.sum = lv.charging_n = 0;
+    }
+
+    void open_file(const std::string &path)
+    {
+        static const HistoryLevel layout[LEVELS] = {
+            {0, 1440, 0, 0, 0, 0, 0, 0, 0, 0, 0},
+            {15 * 60, 960, 0, 0, 0, 0, 0, 0, 0, 0, 0},
+            {2 * 3600, 720, 0, 0, 0, 0, 0, 0, 0, 0, 0},
+        };
+        size_t size = sizeof(HistoryFileHeader);
+        for (auto &lv : layout)
+            size += lv.capacity * sizeof(HistoryPoint);
+
+        int fd = open(path.c_str(), O_RDWR | O_CREAT, 0644);
+        if (fd < 0)
+            return;
+
+        // Anything but an exact match of the current layout starts over
+        struct stat st;
+        HistoryFileHeader existing;
+        bool valid = fstat(fd, &st) == 0 && (size_t)st.st_size == size &&
+                     pread(fd, &existing, sizeof(existing), 0) == (ssize_t)sizeof(existing) &&
+                     existing.magic == MAGIC && existing.version == VERSION &&
+                     existing.level_count == LEVELS;
+        for (int l = 0; valid && l < LEVELS; l++)
+        {
+            valid = existing.levels[l].interval_s == layout[l].interval_s &&
+                    existing.levels[l].capacity == layout[l].capacity &&
+                    existing.levels[l].head < layout[l].capacity &&
+                    existing.levels[l].count <= layout[l].capacity;
+        }
+        if (!valid)
+        {
+            HistoryFileHeader fresh;
+            memset(&fresh, 0, sizeof(fresh));
+            fresh.magic = MAGIC;
+            fresh.version = VERSION;
+            fresh.level_count = LEVELS;
+            memcpy(fresh.levels, layout, sizeof(layout));
+            if (ftruncate(fd, 0) != 0 || ftruncate(fd, size) != 0 ||
+                pwrite(fd, &fresh, sizeof(fresh), 0) != (ssize_t)sizeof(fresh))
+            {
+                close(fd);
+                return;
+            }
+        }
+
+        void *mem = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        close(fd);
+        if (mem == MAP_FAILED)
+            return;
+        map = mem;
+        map_size = size;
+
+        auto *p = reinterpret_cast<HistoryPoint *>(static_cast<char *>(map) + sizeof(HistoryFileHeader));
+        for (int l = 0; l < LEVELS; l++)
+        {
+            rings[l] = p;
+            p += layout[l].capacity;
+        }
+    }
+};
@@ -0,0 +1,196 @@
+#pragma once
+#include <gtk/gtk.h>
+#include <string>
+#include <fstream>
+#include <vector>
+#include <cmath>
+#include "ModularWidget.h"
+#include "BatteryHistory.h"
+
+// Battery level over the last `days`, from BatteryHistory. The series is
+// reduced with LTTB to one point per pixel column whenever a new sample
+// lands or the size changes; exposes only replay that short polyline.
+class BatteryHistoryWidget : public ModularWidget
+{
+public:
+    int days;
+    guint timer_id;
+
+    BatteryHistoryWidget(int col_, int row_,
+                         int width_blocks_, int height_blocks_,
+                         int days_ = 7,
+                         int total_blocks_x_ = 4, int total_blocks_y_ = 4)
+        : ModularWidget(col_, row_, width_blocks_, height_blocks_,
+                        total_blocks_x_, total_blocks_y_),
+          days(std::max(1, std::min(60, days_))), timer_id(0)
+    {
+        gtkWidget = gtk_drawing_area_new();
+        g_signal_connect(G_OBJECT(gtkWidget), "expose-event",
+                         G_CALLBACK(on_expose_static), this);
+
+        sample();
+        timer_id = add_timer(60000, on_update_static, this);
+
+        initialize();
+    }
+
+    ~BatteryHistoryWidget()
+    {
+        if (timer_id > 0) remove_timer(timer_id);
+    }
+
+    const char *type_name() const override { return "BatteryHistoryWidget"; }
+
+    uint64_t state_hash() const override
+    {
+        HistoryPoint last = BatteryHistory::get().latest();
+        int state[3] = {days, static_cast<int>(last.time), last.avg};
+        return hash_bytes(state, sizeof(state));
+    }
+
+    void on_resume() override
+    {
+        if (timer_id > 0) remove_timer(timer_id);
+        sample();
+        timer_id = add_timer(60000, on_update_static, this);
+    }
+
+    void on_display_off() override
+    {
+        stop_timer(timer_id);
+    }
+
+private:
+    // Downsampled series for the current width
+    std::vector<HistoryPoint> points;
+    uint32_t points_generation = UINT32_MAX;
+    int points_width = -1;
+    uint32_t points_from = 0, points_to = 0;
+
+    static gboolean on_update_static(gpointer data)
+    {
+        static_cast<BatteryHistoryWidget *>(data)->sample();
+        return TRUE;
+    }
+
+    void sample()
+    {
+        int percentage = -1;
+        std::ifstream cap_file(BATTERY_CAPACITY_PATH);
+        if (cap_file.is_open())
+            cap_file >> percentage;
+        if (percentage < 0)
+            return;
+
+        bool charging = false;
+        std::ifstream stat_file(BATTERY_STATUS_PATH);
+        if (stat_file.is_open())
+        {
+            std::string status;
+            stat_file >> status;
+            charging = (status == "Charging");
+        }
+
+        BatteryHistory &history = BatteryHistory::get();
+        uint32_t before = history.generation;
+        history.record(Clock::get()->wall_time(), percentage, charging);
+        if (history.generation != before)
+            queue_redraw(REFRESH_BACKGROUND);
+    }
+
+    void refresh_points(int width)
+    {
+        BatteryHistory &history = BatteryHistory::get();
+        if (history.generation == points_generation && width == points_width)
+            return;
+
+        points_to = static_cast<uint32_t>(Clock::get()->wall_time());
+        points_from = points_to - days * 86400;
+        points = BatteryHistory::lttb(history.query(points_from), std::max(width, 3));
+        points_generation = history.generation;
+        points_width = width;
+    }
+
+    static gboolean on_expose_static(GtkWidget *widget, GdkEventExpose *event, gpointer data)
+    {
+        return static_cast<BatteryHistoryWidget *>(data)->on_expose(widget, event);
+    }
+
+    gboolean on_expose(GtkWidget *widget, GdkEventExpose *event)
+    {
+        cairo_t *cr = gdk_cairo_create(widget->window);
+
+        int w = widget->allocation.width;
+        int h = widget->allocation.height;
+
+        double pad = 10.0;
+        double label_h = std::min(24.0, h * 0.2);
+        double gx = pad, gy = pad + label_h;
+        double gw = w - pad * 2, gh = h - pad * 2 - label_h;
+        if (gw <= 2 || gh <= 2)
+        {
+            cairo_destroy(cr);
+            return FALSE;
+        }
+
+        refresh_points(static_cast<int>(gw));
+
+        cairo_set_source_rgb(cr, 0, 0, 0);
+
+        // Frame and one tick per day
+        cairo_set_line_width(cr, 2.0);
+        cairo_rectangle(cr, gx, gy, gw, gh);
+        cairo_stroke(cr);
+        cairo_set_line_width(cr, 1.0);
+        for (int d = 1; d < days; d++)
+        {
+            double x = gx + gw * d / days;
+            cairo_move_to(cr, x, gy + gh);
+            cairo_line_to(cr, x, gy + gh - std::min(8.0, gh * 0.1));
+        }
+        cairo_stroke(cr);
+
+        auto px = [&](const HistoryPoint &p) {
+            return gx + gw * (double)(p.time - points_from) / (points_to - points_from);
+        };
+        auto py = [&](double pct) { return gy + gh * (1.0 - pct / 100.0); };
+
+        // Charging stretches as a grey band along the bottom
+        cairo_set_source_rgb(cr, 0.6, 0.6, 0.6);
+        for (auto &p : points)
+        {
+            if (p.charging >= 128)
+                cairo_rectangle(cr, px(p) - 1, gy + gh - 4, 2, 3);
+        }
+        cairo_fill(cr);
+
+        // Level
+        cairo_set_source_rgb(cr, 0, 0, 0);
+        cairo_set_line_width(cr, 2.0);
+        cairo_set_line_join(cr, CAIRO_LINE_JOIN_ROUND);
+        for (size_t i = 0; i < points.size(); i++)
+        {
+            if (i == 0)
+                cairo_move_to(cr, px(points[i]), py(points[i].avg));
+            else
+                cairo_line_to(cr, px(points[i]), py(points[i].avg));
+        }
+        cairo_stroke(cr);
+
+        // Caption: span and latest level
+        HistoryPoint last = BatteryHistory::get().latest();
+        std::string caption = std::to_string(days) + (days == 1 ? " day" : " days");
+        if (last.time != 0)
+            caption += "  " + std::to_string(last.avg) + "%";
+
+        cairo_select_font_face(cr, "Sans", CAIRO_FONT_SLANT_NORMAL, CAIRO_FONT_WEIGHT_BOLD);
+        cairo_set_font_size(cr, label_h * 0.8);
+        cairo_text_extents_t extents;
+        cairo_text_extents(cr, caption.c_str(), &extents);
+        cairo_move_to(cr, gx + gw - extents.width - extents.x_bearing, pad + label_h * 0.8);
+        cairo_show_text(cr, caption.c_str());
+
+        cairo_destroy(cr);
+        return FALSE;
+    }
+};
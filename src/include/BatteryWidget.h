@@ -3,7 +3,10 @@
 #include <string>
 #include <fstream>
 #include <cmath>
+#include <string.h>
+#include <stdlib.h>
 #include "ModularWidget.h"
+#include "BatteryHistory.h"
 
 class BatteryWidget : public ModularWidget
 {
@@ -12,11 +15,6 @@ public:
     bool is_charging;
     guint timer_id;
 
-    // Common Kindle battery paths (adjust if needed for your specific model)
-    // K3/K4 often use mc13892_bat, Paperwhites often use 'max77696-battery' or just 'battery'
-    const char* BATTERY_CAPACITY_PATH = "/sys/class/power_supply/max77696-battery/capacity";
-    const char* BATTERY_STATUS_PATH   = "/sys/class/power_supply/max77696-battery/status";
-
     BatteryWidget(int col_, int row_,
                   int width_blocks_, int height_blocks_,
                   int total_blocks_x_ = 4, int total_blocks_y_ = 4)
@@ -35,14 +33,69 @@ public:
         read_system_battery();
 
         // Optional: Update every 60 seconds
-        timer_id = g_timeout_add(60000, on_update_static, this);
+        timer_id = add_timer(60000, on_update_static, this);
 
         initialize();
     }
 
     ~BatteryWidget()
     {
-        if (timer_id > 0) g_source_remove(timer_id);
+        if (timer_id > 0) remove_timer(timer_id);
+    }
+
+    const char *type_name() const override { return "BatteryWidget"; }
+
+    uint64_t state_hash() const override
+    {
+        int state[2] = {percentage, is_charging};
+        return hash_bytes(state, sizeof(state));
+    }
+
+    // The level can change a lot while asleep: read it now, poll from here
+    void on_resume() override
+    {
+        if (timer_id > 0) remove_timer(timer_id);
+        read_system_battery();
+        timer_id = add_timer(60000, on_update_static, this);
+    }
+
+    void on_display_off() override
+    {
+        stop_timer(timer_id);
+    }
+
+    size_t save_state(uint8_t *out, size_t max) const override
+    {
+        int32_t state[2] = {percentage, is_charging};
+        memcpy(out, state, sizeof(state));
+        return sizeof(state);
+    }
+
+    // A fresh sysfs reading always wins over the stored one
+    void restore_state(const uint8_t *in, size_t len) override
+    {
+        int32_t state[2];
+        if (has_reading || len != sizeof(state))
+            return;
+        memcpy(state, in, sizeof(state));
+        percentage = std::max(0, std::min(100, static_cast<int>(state[0])));
+        is_charging = state[1] != 0;
+        queue_redraw(REFRESH_BACKGROUND);
+    }
+
+    // Fed from a data file (source=) or a replayed recording: level, charging
+    void on_data(const char *const *keys, const char *const *values, int n) override
+    {
+        int level = percentage;
+        bool charging = is_charging;
+        for (int i = 0; i < n; i++)
+        {
+            if (strcmp(keys[i], "level") == 0)
+                level = atoi(values[i]);
+            else if (strcmp(keys[i], "charging") == 0)
+                charging = strcmp(values[i], "1") == 0 || strcmp(values[i], "true") == 0;
+        }
+        set_values(level, charging);
     }
 
     // Call this manually if you want to set specific values (e.g. from your server)
@@ -50,7 +103,9 @@ public:
     {
         percentage = std::max(0, std::min(100, level));
         is_charging = charging;
-        gtk_widget_queue_draw(gtkWidget);
+        has_reading = true;
+        queue_redraw(REFRESH_BACKGROUND);
+        persist_state();
     }
 
 private:
@@ -63,10 +118,20 @@ private:
     gboolean on_expose(GtkWidget *widget, GdkEventExpose *event)
     {
         cairo_t *cr = gdk_cairo_create(widget->window);
-        
         int w = widget->allocation.width;
         int h = widget->allocation.height;
+        paint_cached(cr, w, h, draw_static, this);
+        cairo_destroy(cr);
+        return FALSE;
+    }
 
+    static void draw_static(cairo_t *cr, int w, int h, gpointer data)
+    {
+        static_cast<BatteryWidget *>(data)->draw(cr, w, h);
+    }
+
+    void draw(cairo_t *cr, int w, int h)
+    {
         // 1. Setup Layout Dimensions
         // Keep some padding so the line thickness doesn't clip
         double pad = 10.0;
@@ -140,9 +205,6 @@ private:
 
         cairo_move_to(cr, text_x, text_y);
         cairo_show_text(cr, label_txt.c_str());
-
-        cairo_destroy(cr);
-        return FALSE;
     }
 
     // ---------------- System Integration ----------------
@@ -158,6 +220,7 @@ private:
         std::ifstream cap_file(BATTERY_CAPACITY_PATH);
         if (cap_file.is_open()) {
             cap_file >> percentage;
+            has_reading = true;
         }
 
         // Try reading status (Charging/Discharging/Full)
@@ -167,7 +230,31 @@ private:
             stat_file >> status;
             is_charging = (status == "Charging");
         }
-        
-        gtk_widget_queue_draw(gtkWidget);
+
+        if (has_reading)
+        {
+            BatteryHistory::get().record(Clock::get()->wall_time(), percentage, is_charging);
+            record_reading();
+        }
+
+        queue_redraw(REFRESH_BACKGROUND);
+        persist_state();
+    }
+
+    bool has_reading = false;
+    int recorded_percentage = -1;
+    bool recorded_charging = false;
+
+    // Readings that changed go into an UpdateLog recording, as on_data() input
+    void record_reading()
+    {
+        if (percentage == recorded_percentage && is_charging == recorded_charging)
+            return;
+        recorded_percentage = percentage;
+        recorded_charging = is_charging;
+        std::string level = std::to_string(percentage);
+        const char *keys[] = {"level", "charging"};
+        const char *values[] = {level.c_str(), is_charging ? "1" : "0"};
+        UpdateRecorder::get().data(state_key(), keys, values, 2);
     }
 };
\ No newline at end of file
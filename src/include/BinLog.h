@@ -0,0 +1,405 @@
+#pragma once
+#include <gtk/gtk.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <signal.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <type_traits>
+#include "Clock.h"
+
+// ----------------- BinLog -----------------
+// Diagnostics without synchronous I/O. BINLOG("fmt", args...) stores the
+// id of its format string and the raw arguments (up to 4: integers,
+// doubles, strings) in a fixed 64-byte entry of the calling thread's ring.
+// Nothing is formatted and no lock is taken on that path. Each ring has a
+// single producer (its thread) and a single consumer (the flush). When a
+// ring is full, new entries are dropped and counted.
+//
+// The rings are flushed to the log file in one large write: from a timer
+// on the process Clock some seconds after the main thread logged, on the
+// next main-loop turn when its ring is 3/4 full, at exit, and from the
+// crash signal handlers. Format strings go into the file once per session;
+// dynamic-widget-logdump turns the file back into text.
+//
+// File: a sequence of records, each a BinLogTag byte followed by its
+// payload (packed, little endian). Every run appends a new session.
+
+#pragma pack(push, 1)
+struct BinLogSession
+{
+    uint32_t magic; // 'DWBL'
+    uint16_t version;
+    uint32_t pid;
+    int64_t wall_us;
+};
+
+struct BinLogFormat
+{
+    uint16_t id;
+    uint16_t length; // chars that follow
+};
+
+struct BinLogEntry
+{
+    int64_t wall_us;
+    uint32_t thread;
+    uint16_t format;
+    uint8_t nargs;
+    uint8_t types; // 2 bits per argument, BinLogArg
+    uint8_t args[48];
+};
+
+struct BinLogDropped
+{
+    uint32_t thread;
+    uint32_t count;
+};
+#pragma pack(pop)
+
+enum BinLogTag : uint8_t
+{
+    BINLOG_SESSION = 1,
+    BINLOG_FORMAT = 2,
+    BINLOG_EVENT = 3,
+    BINLOG_DROPPED = 4,
+};
+
+enum BinLogArg : uint8_t
+{
+    BINLOG_INT = 0,    // int64
+    BINLOG_DOUBLE = 1, // double
+    BINLOG_STRING = 2, // length byte + chars, truncated to fit
+};
+
+// Function-local static: the format is interned once per call site
+#define BINLOG(fmt, ...)                                           \
+    do                                                             \
+    {                                                              \
+        static const uint16_t binlog_format_ = BinLog::intern(fmt); \
+        BinLog::write(binlog_format_, ##__VA_ARGS__);              \
+    } while (0)
+
+class BinLog
+{
+public:
+    static constexpr uint32_t MAGIC = 0x4C425744; // "DWBL"
+    static constexpr uint16_t VERSION = 1;
+    static constexpr uint32_t RING_SIZE = 256; // entries per thread, power of two
+    static constexpr int MAX_THREADS = 16;
+    static constexpr int MAX_FORMATS = 512;
+    static constexpr guint FLUSH_DELAY_MS = 30000;
+    static constexpr off_t MAX_FILE = 1024 * 1024; // then rotated to <path>.old
+
+    // Start logging to `path` from the main thread (until then BINLOG is a
+    // no-op); installs the crash handlers
+    static bool open(const std::string &path)
+    {
+        log_path = path;
+        if (!open_file())
+            return false;
+        main_ring = &ring();
+        BinLogSession session{MAGIC, VERSION, static_cast<uint32_t>(getpid()), now_us()};
+        write_record(BINLOG_SESSION, &session, sizeof(session));
+
+        for (int sig : {SIGSEGV, SIGBUS, SIGILL, SIGFPE, SIGABRT})
+        {
+            struct sigaction sa = {};
+            sa.sa_handler = on_crash;
+            sa.sa_flags = SA_RESETHAND;
+            sigaction(sig, &sa, NULL);
+        }
+        atexit([] { flush(false); });
+        enabled.store(true, std::memory_order_release);
+        return true;
+    }
+
+    static uint16_t intern(const char *fmt)
+    {
+        std::lock_guard<std::mutex> lock(format_mutex);
+        uint16_t n = format_count.load(std::memory_order_relaxed);
+        for (uint16_t i = 1; i <= n; i++)
+        {
+            if (formats[i] == fmt)
+                return i;
+        }
+        if (n + 1 >= MAX_FORMATS)
+            return 0; // table full: the site stays silent
+        formats[n + 1] = fmt;
+        format_count.store(n + 1, std::memory_order_release);
+        return n + 1;
+    }
+
+    template <typename... Args>
+    static void write(uint16_t format, Args... args)
+    {
+        static_assert(sizeof...(Args) <= 4, "BINLOG takes at most 4 arguments");
+        if (!format || !enabled.load(std::memory_order_acquire))
+            return;
+
+        Ring &r = ring();
+        uint32_t head = r.head.load(std::memory_order_relaxed);
+        uint32_t tail = r.tail.load(std::memory_order_acquire);
+        if (head - tail >= RING_SIZE)
+        {
+            r.dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+
+        BinLogEntry &e = r.slots[head & (RING_SIZE - 1)];
+        e.wall_us = now_us();
+        e.thread = r.thread;
+        e.format = format;
+        e.nargs = 0;
+        e.types = 0;
+        size_t pos = 0;
+        int expand[] = {0, (put(e, pos, args), 0)...};
+        (void)expand;
+        (void)pos; // no arguments
+        r.head.store(head + 1, std::memory_order_release);
+
+        if (&r == main_ring)
+            schedule_flush(head + 1 - tail >= RING_SIZE * 3 / 4);
+    }
+
+    // Drain every ring into the file. Only write(2) and a static buffer, so
+    // the crash handlers can call it too.
+    static void flush(bool from_signal)
+    {
+        if (fd < 0)
+            return;
+        uint16_t n = format_count.load(std::memory_order_acquire);
+        for (uint16_t id = formats_written + 1; id <= n; id++)
+        {
+            BinLogFormat f{id, static_cast<uint16_t>(strlen(formats[id]))};
+            append_tag(BINLOG_FORMAT);
+            append(&f, sizeof(f));
+            append(formats[id], f.length);
+        }
+        formats_written = n;
+
+        int count = ring_count.load(std::memory_order_acquire);
+        for (int i = 0; i < count; i++)
+        {
+            Ring *r = rings[i];
+            if (!r)
+                continue;
+            uint32_t tail = r->tail.load(std::memory_order_relaxed);
+            uint32_t head = r->head.load(std::memory_order_acquire);
+            for (; tail != head; tail++)
+            {
+                append_tag(BINLOG_EVENT);
+                append(&r->slots[tail & (RING_SIZE - 1)], sizeof(BinLogEntry));
+            }
+            r->tail.store(tail, std::memory_order_release);
+
+            uint32_t dropped = r->dropped.exchange(0, std::memory_order_relaxed);
+            if (dropped)
+            {
+                BinLogDropped d{r->thread, dropped};
+                append_tag(BINLOG_DROPPED);
+                append(&d, sizeof(d));
+            }
+        }
+        write_out();
+
+        if (!from_signal && file_size > MAX_FILE)
+            rotate();
+    }
+
+private:
+    struct Ring
+    {
+        std::atomic<uint32_t> head{0};
+        std::atomic<uint32_t> tail{0};
+        std::atomic<uint32_t> dropped{0};
+        uint32_t thread;
+        BinLogEntry slots[RING_SIZE];
+    };
+
+    static inline std::string log_path;
+    static inline int fd = -1;
+    static inline off_t file_size = 0;
+    static inline std::atomic<bool> enabled{false};
+    static inline Ring *main_ring = nullptr;
+    static inline guint flush_id = 0;
+    static inline bool flush_soon = false;
+
+    static inline Ring *rings[MAX_THREADS];
+    static inline std::atomic<int> ring_count{0};
+    static inline std::mutex format_mutex;
+    static inline const char *formats[MAX_FORMATS];
+    static inline std::atomic<uint16_t> format_count{0};
+    static inline uint16_t formats_written = 0;
+
+    static inline char out[32 * 1024];
+    static inline size_t out_len = 0;
+
+    static int64_t now_us()
+    {
+        struct timespec ts;
+        clock_gettime(CLOCK_REALTIME, &ts);
+        return static_cast<int64_t>(ts.tv_sec) * 1000000 + ts.tv_nsec / 1000;
+    }
+
+    // The calling thread's ring, registered on first use
+    static Ring &ring()
+    {
+        static thread_local Ring *mine = nullptr;
+        if (!mine)
+        {
+            mine = new Ring;
+            mine->thread = static_cast<uint32_t>(syscall(SYS_gettid));
+            int i = ring_count.load(std::memory_order_relaxed);
+            while (i < MAX_THREADS && !ring_count.compare_exchange_weak(i, i + 1))
+                ;
+            if (i < MAX_THREADS)
+                rings[i] = mine; // else never flushed; fills and counts drops
+        }
+        return *mine;
+    }
+
+    // Main thread only (GLib and the Clock are not used from other threads)
+    static void schedule_flush(bool urgent)
+    {
+        if (urgent && !flush_soon)
+        {
+            if (flush_id)
+                Clock::get()->remove(flush_id);
+            flush_soon = true;
+            flush_id = Clock::get()->add_timeout(0, on_flush_static, NULL);
+        }
+        else if (!flush_id)
+        {
+            flush_id = Clock::get()->add_timeout(FLUSH_DELAY_MS, on_flush_static, NULL);
+        }
+    }
+
+    static gboolean on_flush_static(gpointer)
+    {
+        flush_id = 0;
+        flush_soon = false;
+        flush(false);
+        return FALSE;
+    }
+
+    template <typename T>
+    static void put(BinLogEntry &e, size_t &pos, T v)
+    {
+        if constexpr (std::is_floating_point<T>::value)
+        {
+            double d = v;
+            put_raw(e, pos, BINLOG_DOUBLE, &d, sizeof(d));
+        }
+        else if constexpr (std::is_same<T, const char *>::value || std::is_same<T, char *>::value)
+        {
+            const char *s = v ? v : "(null)";
+            size_t room = sizeof(e.args) - pos;
+            if (room < 1)
+                return;
+            size_t len = std::min(strlen(s), std::min<size_t>(room - 1, 255));
+            e.args[pos] = static_cast<uint8_t>(len);
+            memcpy(e.args + pos + 1, s, len);
+            pos += 1 + len;
+            e.types |= BINLOG_STRING << (2 * e.nargs);
+            e.nargs++;
+        }
+        else
+        {
+            static_assert(std::is_integral<T>::value || std::is_enum<T>::value, "BINLOG argument type");
+            int64_t i = static_cast<int64_t>(v);
+            put_raw(e, pos, BINLOG_INT, &i, sizeof(i));
+        }
+    }
+
+    static void put_raw(BinLogEntry &e, size_t &pos, BinLogArg type, const void *v, size_t len)
+    {
+        if (pos + len > sizeof(e.args))
+            return; // no room left after long strings
+        memcpy(e.args + pos, v, len);
+        pos += len;
+        e.types |= type << (2 * e.nargs);
+        e.nargs++;
+    }
+
+    static bool open_file()
+    {
+        fd = ::open(log_path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+        if (fd < 0)
+        {
+            perror("[LOG] open");
+            return false;
+        }
+        struct stat st;
+        file_size = fstat(fd, &st) == 0 ? st.st_size : 0;
+        return true;
+    }
+
+    // Keep one previous file; the new one starts with a fresh session
+    static void rotate()
+    {
+        close(fd);
+        rename(log_path.c_str(), (log_path + ".old").c_str());
+        if (!open_file())
+            return;
+        formats_written = 0;
+        BinLogSession session{MAGIC, VERSION, static_cast<uint32_t>(getpid()), now_us()};
+        write_record(BINLOG_SESSION, &session, sizeof(session));
+        flush(false); // format table for the new file
+    }
+
+    static void write_record(BinLogTag tag, const void *data, size_t len)
+    {
+        append_tag(tag);
+        append(data, len);
+        write_out();
+    }
+
+    static void append_tag(BinLogTag tag)
+    {
+        uint8_t t = tag;
+        append(&t, 1);
+    }
+
+    static void append(const void *data, size_t len)
+    {
+        const char *p = static_cast<const char *>(data);
+        while (len > 0)
+        {
+            if (out_len == sizeof(out))
+                write_out();
+            size_t n = std::min(len, sizeof(out) - out_len);
+            memcpy(out + out_len, p, n);
+            out_len += n;
+            p += n;
+            len -= n;
+        }
+    }
+
+    static void write_out()
+    {
+        size_t done = 0;
+        while (done < out_len)
+        {
+            ssize_t n = ::write(fd, out + done, out_len - done);
+            if (n <= 0)
+                break; // disk full or gone: drop the batch
+            done += n;
+        }
+        file_size += done;
+        out_len = 0;
+    }
+
+    static void on_crash(int sig)
+    {
+        flush(true);
+        raise(sig); // SA_RESETHAND: the default action now
+    }
+};
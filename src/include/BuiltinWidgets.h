@@ -0,0 +1,32 @@
+#pragma once
+#include "WidgetRegistry.h"
+#include "SpeakerGrill.h"
+#include "SpeakerGrillCounter.h"
+#include "TimeAndDateWidget.h"
+#include "BatteryWidget.h"
+
+// Widgets compiled into the main binary: small and on nearly every layout.
+// Everything else ships as a plugin (src/plugins/).
+inline void register_builtin_widgets()
+{
+    WidgetRegistry &reg = WidgetRegistry::get();
+
+    reg.add("SpeakerGrill", [](const WidgetParams *p) -> ModularWidget * {
+        return new SpeakerGrill(p->col, p->row, p->width_blocks, p->height_blocks,
+                                p->get_int("radius", 16));
+    });
+
+    reg.add("SpeakerGrillCounter", [](const WidgetParams *p) -> ModularWidget * {
+        return new SpeakerGrillCounter(p->col, p->row, p->width_blocks, p->height_blocks,
+                                       p->get_int("radius", 16), p->get("period", "minute"));
+    });
+
+    reg.add("TimeDateWidget", [](const WidgetParams *p) -> ModularWidget * {
+        return new TimeDateWidget(p->col, p->row, p->width_blocks, p->height_blocks,
+                                  p->get_int("blocks", 1), p->get_bool("seconds", true));
+    });
+
+    reg.add("BatteryWidget", [](const WidgetParams *p) -> ModularWidget * {
+        return new BatteryWidget(p->col, p->row, p->width_blocks, p->height_blocks);
+    });
+}
@@ -0,0 +1,164 @@
+#pragma once
+#include <gtk/gtk.h>
+#include <stdint.h>
+#include <time.h>
+#include <map>
+
+// ----------------- Clock -----------------
+// Every widget and timer reads time and schedules wakeups through
+// Clock::get(). Production uses SystemClock (GLib timeouts, real time);
+// the soak/replay tools install a VirtualClock and warp time forward.
+class Clock
+{
+public:
+    virtual ~Clock() {}
+
+    virtual int64_t monotonic_us() = 0;
+    virtual time_t wall_time() = 0;
+
+    // Same contract as g_timeout_add_full: `func` returning FALSE removes
+    // the timer, `notify` (may be null) runs when it is gone
+    virtual guint add_timeout(guint interval_ms, GSourceFunc func, gpointer data,
+                              GDestroyNotify notify = nullptr) = 0;
+    virtual void remove(guint id) = 0;
+
+    // Wall time with millisecond resolution (for deadlines between seconds)
+    virtual int64_t wall_time_ms() { return static_cast<int64_t>(wall_time()) * 1000; }
+
+    struct tm local_time()
+    {
+        time_t now = wall_time();
+        struct tm t;
+        localtime_r(&now, &t);
+        return t;
+    }
+
+    static Clock *&get();
+};
+
+class SystemClock : public Clock
+{
+public:
+    int64_t monotonic_us() override
+    {
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return static_cast<int64_t>(ts.tv_sec) * 1000000 + ts.tv_nsec / 1000;
+    }
+
+    time_t wall_time() override { return time(NULL); }
+
+    int64_t wall_time_ms() override
+    {
+        struct timespec ts;
+        clock_gettime(CLOCK_REALTIME, &ts);
+        return static_cast<int64_t>(ts.tv_sec) * 1000 + ts.tv_nsec / 1000000;
+    }
+
+    guint add_timeout(guint interval_ms, GSourceFunc func, gpointer data,
+                      GDestroyNotify notify = nullptr) override
+    {
+        return g_timeout_add_full(G_PRIORITY_DEFAULT, interval_ms, func, data, notify);
+    }
+
+    void remove(guint id) override { g_source_remove(id); }
+};
+
+inline Clock *&Clock::get()
+{
+    static SystemClock system_clock;
+    static Clock *clock = &system_clock;
+    return clock;
+}
+
+// Simulated time: nothing fires until advance() is called, then every timer
+// that falls due runs in order with the clock set to its due time.
+class VirtualClock : public Clock
+{
+public:
+    uint64_t dispatched = 0; // timer callbacks run so far
+
+    VirtualClock(time_t start_wall = time(NULL))
+        : now_us(0), wall_base(start_wall), next_id(1) {}
+
+    int64_t monotonic_us() override { return now_us; }
+    time_t wall_time() override { return wall_base + now_us / 1000000; }
+    int64_t wall_time_ms() override { return static_cast<int64_t>(wall_base) * 1000 + now_us / 1000; }
+
+    guint add_timeout(guint interval_ms, GSourceFunc func, gpointer data,
+                      GDestroyNotify notify = nullptr) override
+    {
+        guint id = next_id++;
+        Timer t{id, static_cast<int64_t>(interval_ms) * 1000, func, data, notify};
+        queue.emplace(now_us + t.interval_us, t);
+        return id;
+    }
+
+    void remove(guint id) override
+    {
+        if (id == running_id)
+        {
+            running_removed = true; // dropped when its callback returns
+            return;
+        }
+        for (auto it = queue.begin(); it != queue.end(); ++it)
+        {
+            if (it->second.id == id)
+            {
+                Timer t = it->second;
+                queue.erase(it);
+                if (t.notify)
+                    t.notify(t.data);
+                return;
+            }
+        }
+    }
+
+    // Due time of the earliest timer, or -1 when none is pending
+    int64_t next_due_us() const
+    {
+        return queue.empty() ? -1 : queue.begin()->first;
+    }
+
+    // Move time forward by `us`, firing every timer that falls due
+    void advance(int64_t us)
+    {
+        int64_t target = now_us + us;
+        while (!queue.empty() && queue.begin()->first <= target)
+        {
+            auto it = queue.begin();
+            Timer t = it->second;
+            now_us = it->first;
+            queue.erase(it);
+
+            dispatched++;
+            running_id = t.id;
+            running_removed = false;
+            bool again = t.func(t.data);
+            running_id = 0;
+
+            if (again && !running_removed)
+                queue.emplace(now_us + t.interval_us, t);
+            else if (t.notify)
+                t.notify(t.data);
+        }
+        now_us = target;
+    }
+
+private:
+    struct Timer
+    {
+        guint id;
+        int64_t interval_us;
+        GSourceFunc func;
+        gpointer data;
+        GDestroyNotify notify;
+    };
+
+    int64_t now_us;
+    time_t wall_base;
+    guint next_id;
+    guint running_id = 0;
+    bool running_removed = false;
+    std::multimap<int64_t, Timer> queue;
+};
@@ -0,0 +1,25 @@
+#pragma once
+#include "KindleWindow.h"
+#include "WidgetRegistry.h"
+
+// The default dashboard layout, shared by the app and the soak harness.
+// Widgets are created by type name (built-in or plugin) and added lazily:
+// they are built from the main loop.
+inline void build_dashboard(KindleWindow &kw)
+{
+    static const WidgetSpec layout[] = {
+        {"SpeakerGrill", 1, 1, 4, 1, {{"radius", "16"}}},
+        {"TimeDateWidget", 1, 2, 2, 1, {{"blocks", "1"}, {"seconds", "false"}}},
+        {"WeatherWidget", 3, 2, 2, 1, {{"icon", ""}, {"temperature", "19"}, {"condition", "Rainy"}}},
+        {"SpeakerGrill", 1, 3, 1, 1, {{"radius", "16"}}},
+        {"SpeakerGrillCounter", 2, 3, 1, 1, {{"radius", "16"}}},
+        {"SpeakerGrillDice", 3, 3, 1, 1, {}},
+        {"QuoteWidget", 1, 4, 4, 1,
+         {{"text", "Two things are infinite: the universe and human stupidity; and I'm not sure about the universe."}}},
+        // Battery at column 4, row 3
+        {"BatteryWidget", 4, 3, 1, 1, {}},
+    };
+
+    for (const WidgetSpec &spec : layout)
+        kw.add_widget_lazily([&spec] { return spec.create(); });
+}
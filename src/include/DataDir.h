@@ -0,0 +1,24 @@
+#pragma once
+#include <gtk/gtk.h>
+#include <string>
+#include <unistd.h>
+
+// Directory for files that must survive a restart (snapshots, caches, state).
+// $DWK_DATA_DIR overrides it; on a Kindle the user partition is used,
+// elsewhere the XDG cache directory.
+inline std::string data_path(const char *name)
+{
+    static const std::string dir = [] {
+        std::string d;
+        const char *env = g_getenv("DWK_DATA_DIR");
+        if (env && *env)
+            d = env;
+        else if (access("/mnt/us", W_OK) == 0)
+            d = "/mnt/us/dynamic-widget";
+        else
+            d = std::string(g_get_user_cache_dir()) + "/dynamic-widget-kindle";
+        g_mkdir_with_parents(d.c_str(), 0755);
+        return d;
+    }();
+    return dir + "/" + name;
+}
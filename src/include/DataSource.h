@@ -0,0 +1,364 @@
+#pragma once
+#include <gtk/gtk.h>
+#include <stdio.h>
+#include <string.h>
+#include <ctype.h>
+#include <unistd.h>
+#include <errno.h>
+#include <algorithm>
+#include <map>
+#include <string>
+#include <vector>
+#include <sys/inotify.h>
+#include "ModularWidget.h"
+#include "Clock.h"
+#include "WorkerPool.h"
+#include "BinLog.h"
+
+// ----------------- Data sources -----------------
+// Widgets fed from local files that scripts drop in place. A layout line
+// binds a widget with `source=<path>`; the file holds `key=value` lines
+// (# comments, "quoted" values), or with `source_field=<key>` its whole
+// content is that one field (e.g. a quote).
+//
+// One inotify fd watches the parent directories (so rename-into-place
+// works) and sits in the main loop: no timers at all while nothing changes.
+// A burst of writes only re-arms a one-shot debounce; when it fires, each
+// touched file is read and parsed once on the worker pool and just the
+// fields that differ from the last parse are handed to the bound widgets
+// (on_data).
+class DataSources
+{
+public:
+    static constexpr guint DEBOUNCE_MS = 300;
+
+    static DataSources &get()
+    {
+        static DataSources sources;
+        return sources;
+    }
+
+    DataSources(const DataSources &) = delete;
+    DataSources &operator=(const DataSources &) = delete;
+
+    // Feed `widget` from `path`. It gets the full current field set once
+    // (after the debounce, i.e. after its persisted state was restored),
+    // then only changes. Plain C strings: plugins call in here.
+    void bind(const char *path, const char *whole_field, ModularWidget *widget)
+    {
+        if (!widget || !path || !*path)
+            return;
+        Source &src = source(path, whole_field, false);
+        if (src.wd < 0)
+            return;
+        src.widgets.push_back(widget);
+        src.fresh.push_back(widget);
+        if (!src.parsed)
+            src.pending = true;
+        schedule();
+    }
+
+    // Only signal changes of `path` to `widget`, as on_data("changed", path),
+    // for files the widget reads itself (e.g. a large .ics). Fires once
+    // right after binding too.
+    void watch(const char *path, ModularWidget *widget)
+    {
+        if (!widget || !path || !*path)
+            return;
+        Source &src = source(path, "", true);
+        if (src.wd < 0)
+            return;
+        src.widgets.push_back(widget);
+        src.fresh.push_back(widget);
+        schedule();
+    }
+
+    // Drop every binding of a widget that is going away
+    void unbind(ModularWidget *widget)
+    {
+        for (auto &src : sources)
+        {
+            src.widgets.erase(std::remove(src.widgets.begin(), src.widgets.end(), widget), src.widgets.end());
+            src.fresh.erase(std::remove(src.fresh.begin(), src.fresh.end(), widget), src.fresh.end());
+        }
+    }
+
+private:
+    typedef std::map<std::string, std::string> Fields;
+
+    struct Source
+    {
+        std::string dir, name, whole_field;
+        int wd = -1;
+        bool notify_only = false; // watch(): widgets read the file themselves
+        bool pending = false; // changed, not read yet
+        bool reading = false; // parse running on the worker pool
+        bool parsed = false;
+        Fields fields;
+        std::vector<ModularWidget *> widgets;
+        std::vector<ModularWidget *> fresh; // bound since the last push
+    };
+
+    // One parse on the worker pool: copies of the inputs, then the parsed
+    // fields, or ok = false if the file is unreadable
+    struct ParseJob
+    {
+        DataSources *self;
+        size_t index;
+        std::string path, whole_field;
+        bool ok = false;
+        Fields fields;
+    };
+
+    std::vector<Source> sources; // never shrinks; jobs refer to indices
+    int fd = -1;
+    guint watch_id = 0;
+    guint debounce_id = 0;
+
+    DataSources()
+    {
+        ModularWidget::on_destroy() = [](ModularWidget *w) { get().unbind(w); };
+    }
+
+    Source &source(const std::string &path, const std::string &whole_field, bool notify_only)
+    {
+        for (auto &src : sources)
+        {
+            if (src.dir + "/" + src.name == path && src.whole_field == whole_field &&
+                src.notify_only == notify_only)
+                return src;
+        }
+
+        Source src;
+        size_t slash = path.rfind('/');
+        src.dir = slash == std::string::npos ? "." : (slash == 0 ? "" : path.substr(0, slash));
+        src.name = slash == std::string::npos ? path : path.substr(slash + 1);
+        src.whole_field = whole_field;
+        src.notify_only = notify_only;
+        src.wd = watch_dir(src.dir.empty() ? "/" : src.dir);
+        sources.push_back(src);
+        return sources.back();
+    }
+
+    int watch_dir(const std::string &dir)
+    {
+        if (fd < 0)
+        {
+            fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+            if (fd < 0)
+            {
+                BINLOG("[DATA] inotify_init1 failed, errno %d", errno);
+                return -1;
+            }
+            GIOChannel *ch = g_io_channel_unix_new(fd);
+            watch_id = g_io_add_watch(ch, G_IO_IN, on_inotify_static, this);
+            g_io_channel_unref(ch);
+        }
+        // Same directory twice yields the same wd
+        int wd = inotify_add_watch(fd, dir.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+        if (wd < 0)
+            BINLOG("[DATA] cannot watch %s, errno %d", dir.c_str(), errno);
+        return wd;
+    }
+
+    static gboolean on_inotify_static(GIOChannel *source, GIOCondition condition, gpointer data)
+    {
+        static_cast<DataSources *>(data)->drain();
+        return TRUE;
+    }
+
+    void drain()
+    {
+        alignas(struct inotify_event) char buf[4096];
+        bool touched = false;
+        for (;;)
+        {
+            ssize_t n = read(fd, buf, sizeof(buf));
+            if (n <= 0)
+                break;
+            for (char *p = buf; p < buf + n;)
+            {
+                auto *ev = reinterpret_cast<struct inotify_event *>(p);
+                p += sizeof(struct inotify_event) + ev->len;
+                if (ev->len == 0)
+                    continue;
+                for (auto &src : sources)
+                {
+                    if (src.wd == ev->wd && src.name == ev->name)
+                    {
+                        src.pending = true;
+                        touched = true;
+                    }
+                }
+            }
+        }
+        if (touched)
+            schedule();
+    }
+
+    // (Re)start the one-shot debounce
+    void schedule()
+    {
+        if (debounce_id > 0)
+            Clock::get()->remove(debounce_id);
+        debounce_id = Clock::get()->add_timeout(DEBOUNCE_MS, on_debounce_static, this);
+    }
+
+    static gboolean on_debounce_static(gpointer data)
+    {
+        auto *self = static_cast<DataSources *>(data);
+        self->debounce_id = 0;
+        self->flush();
+        return FALSE;
+    }
+
+    void flush()
+    {
+        for (size_t i = 0; i < sources.size(); i++)
+        {
+            Source &src = sources[i];
+            if (src.notify_only)
+            {
+                Fields changed{{"changed", src.dir + "/" + src.name}};
+                std::vector<ModularWidget *> targets;
+                targets.swap(src.fresh);
+                if (src.pending)
+                    targets = src.widgets;
+                src.pending = false;
+                for (ModularWidget *w : targets)
+                    push(w, changed);
+            }
+            else if (src.pending && !src.reading)
+            {
+                // Parse off the main loop; the copies keep the job independent
+                src.pending = false;
+                src.reading = true;
+                auto *job = new ParseJob{this, i, src.dir + "/" + src.name, src.whole_field};
+                WorkerPool::get().submit(this, parse_static, parsed_static, job, free_job_static);
+            }
+            else if (!src.reading)
+                push_fresh(src);
+        }
+    }
+
+    static void parse_static(gpointer data)
+    {
+        auto *job = static_cast<ParseJob *>(data);
+        job->ok = read_fields(job->path, job->whole_field, job->fields);
+    }
+
+    static void parsed_static(gpointer data)
+    {
+        auto *job = static_cast<ParseJob *>(data);
+        job->self->apply(job->index, *job);
+    }
+
+    static void free_job_static(gpointer data)
+    {
+        delete static_cast<ParseJob *>(data);
+    }
+
+    void apply(size_t index, ParseJob &r)
+    {
+        Source &src = sources[index];
+        src.reading = false;
+        if (r.ok)
+        {
+            Fields changed;
+            for (auto &kv : r.fields)
+            {
+                auto it = src.fields.find(kv.first);
+                if (it == src.fields.end() || it->second != kv.second)
+                    changed.insert(kv);
+            }
+            src.fields.swap(r.fields);
+            src.parsed = true;
+
+            for (ModularWidget *w : src.widgets)
+            {
+                if (std::find(src.fresh.begin(), src.fresh.end(), w) == src.fresh.end())
+                    push(w, changed);
+            }
+            if (!changed.empty())
+                BINLOG("[DATA] %s: %zu field(s) changed", src.name.c_str(), changed.size());
+        }
+        push_fresh(src);
+
+        // Written again while we were parsing
+        if (src.pending)
+            schedule();
+    }
+
+    // Widgets bound since the last push get every field once
+    void push_fresh(Source &src)
+    {
+        std::vector<ModularWidget *> fresh;
+        fresh.swap(src.fresh);
+        for (ModularWidget *w : fresh)
+            push(w, src.fields);
+    }
+
+    static void push(ModularWidget *w, const Fields &fields)
+    {
+        if (fields.empty())
+            return;
+        std::vector<const char *> keys, values;
+        for (auto &kv : fields)
+        {
+            keys.push_back(kv.first.c_str());
+            values.push_back(kv.second.c_str());
+        }
+        UpdateRecorder::get().data(w->state_key(), keys.data(), values.data(), static_cast<int>(fields.size()));
+        w->on_data(keys.data(), values.data(), static_cast<int>(fields.size()));
+    }
+
+    // Worker thread: plain stdio, no GLib
+    static bool read_fields(const std::string &path, const std::string &whole_field, Fields &out)
+    {
+        FILE *f = fopen(path.c_str(), "rb");
+        if (!f)
+            return false;
+        std::string content;
+        char buf[4096];
+        size_t n;
+        while ((n = fread(buf, 1, sizeof(buf), f)) > 0)
+            content.append(buf, n);
+        fclose(f);
+
+        if (!whole_field.empty())
+        {
+            while (!content.empty() && isspace((unsigned char)content.back()))
+                content.pop_back();
+            out[whole_field] = content;
+            return true;
+        }
+
+        size_t pos = 0;
+        while (pos < content.size())
+        {
+            size_t nl = content.find('\n', pos);
+            std::string line = content.substr(pos, nl == std::string::npos ? std::string::npos : nl - pos);
+            pos = nl == std::string::npos ? content.size() : nl + 1;
+
+            size_t eq = line.find('=');
+            std::string key = trim(line.substr(0, eq));
+            if (eq == std::string::npos || key.empty() || key[0] == '#')
+                continue;
+            std::string value = trim(line.substr(eq + 1));
+            if (value.size() >= 2 && value.front() == '"' && value.back() == '"')
+                value = value.substr(1, value.size() - 2);
+            out[key] = value;
+        }
+        return true;
+    }
+
+    static std::string trim(const std::string &s)
+    {
+        size_t b = 0, e = s.size();
+        while (b < e && isspace((unsigned char)s[b]))
+            b++;
+        while (e > b && isspace((unsigned char)s[e - 1]))
+            e--;
+        return s.substr(b, e - b);
+    }
+};
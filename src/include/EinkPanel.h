@@ -0,0 +1,206 @@
+#pragma once
+#include <errno.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <linux/fb.h>
+#include "BinLog.h"
+
+// ----------------- EinkPanel -----------------
+// Direct access to the Kindle framebuffer and the e-ink controller, for work
+// that has to happen outside GTK (before gtk_init, or explicit refreshes).
+// Only 8bpp grayscale panels are handled (Paperwhite and later); on anything
+// else, including a desktop without /dev/fb0, every call is a no-op.
+
+// Lab126 mxcfb interface (Paperwhite 2 layout)
+struct mxcfb_rect
+{
+    uint32_t top;
+    uint32_t left;
+    uint32_t width;
+    uint32_t height;
+};
+
+struct mxcfb_alt_buffer_data
+{
+    uint32_t phys_addr;
+    uint32_t width;
+    uint32_t height;
+    struct mxcfb_rect alt_update_region;
+};
+
+struct mxcfb_update_data
+{
+    struct mxcfb_rect update_region;
+    uint32_t waveform_mode;
+    uint32_t update_mode;
+    uint32_t update_marker;
+    uint32_t hist_bw_waveform_mode;
+    uint32_t hist_gray_waveform_mode;
+    int temp;
+    unsigned int flags;
+    struct mxcfb_alt_buffer_data alt_buffer_data;
+};
+
+#define MXCFB_SEND_UPDATE _IOW('F', 0x2E, struct mxcfb_update_data)
+#define MXCFB_TEMP_USE_AMBIENT 0x1000
+#define MXCFB_GRAYSCALE_8BIT_INVERTED 0x2
+
+class EinkPanel
+{
+public:
+    enum Waveform
+    {
+        WAVEFORM_DU = 1,   // fast black/white, no flash
+        WAVEFORM_GC16 = 2, // full-quality 16 gray levels
+        WAVEFORM_A2 = 4,   // fastest, 1-bit
+        WAVEFORM_GL16 = 5, // quality, less flashing on white background
+        WAVEFORM_AUTO = 257
+    };
+
+    int fd;
+    int width, height; // visible resolution
+    int stride;        // bytes per line
+    bool inverted;     // 0xFF is black
+    uint8_t *fb;
+    size_t fb_size;
+    uint32_t next_marker;
+
+    // Shared instance, opened on first use
+    static EinkPanel &get()
+    {
+        static EinkPanel panel("/dev/fb0");
+        return panel;
+    }
+
+    bool is_open() const { return fb != nullptr; }
+
+    // Copy 8-bit gray pixels (0 = black) into the framebuffer
+    bool blit_gray8(int x, int y, int w, int h, const uint8_t *src, int src_stride)
+    {
+        if (!is_open())
+            return false;
+        if (!clip(x, y, w, h, src, src_stride))
+            return true;
+
+        for (int j = 0; j < h; j++)
+        {
+            uint8_t *dst = fb + (size_t)(y + j) * stride + x;
+            const uint8_t *row = src + (size_t)j * src_stride;
+            if (inverted)
+            {
+                for (int i = 0; i < w; i++)
+                    dst[i] = 0xFF - row[i];
+            }
+            else
+            {
+                memcpy(dst, row, w);
+            }
+        }
+        return true;
+    }
+
+    // Gray level (0 = black) of one framebuffer pixel, -1 outside the panel
+    int gray_at(int x, int y) const
+    {
+        if (!is_open() || x < 0 || y < 0 || x >= width || y >= height)
+            return -1;
+        uint8_t v = fb[(size_t)y * stride + x];
+        return inverted ? 0xFF - v : v;
+    }
+
+    // Ask the controller to refresh a region; `full` flashes (clears ghosting)
+    bool send_update(int x, int y, int w, int h, Waveform waveform, bool full)
+    {
+        if (!is_open())
+            return false;
+
+        struct mxcfb_update_data update;
+        memset(&update, 0, sizeof(update));
+        update.update_region.left = x;
+        update.update_region.top = y;
+        update.update_region.width = w;
+        update.update_region.height = h;
+        update.waveform_mode = waveform;
+        update.update_mode = full ? 1 : 0; // UPDATE_MODE_FULL / PARTIAL
+        update.update_marker = ++next_marker;
+        update.temp = MXCFB_TEMP_USE_AMBIENT;
+
+        if (ioctl(fd, MXCFB_SEND_UPDATE, &update) < 0)
+        {
+            BINLOG("[EINK] MXCFB_SEND_UPDATE failed, errno %d", errno);
+            return false;
+        }
+        return true;
+    }
+
+private:
+    EinkPanel(const char *path)
+        : fd(-1), width(0), height(0), stride(0), inverted(false),
+          fb(nullptr), fb_size(0), next_marker(0)
+    {
+        fd = open(path, O_RDWR);
+        if (fd < 0)
+            return;
+
+        struct fb_var_screeninfo var;
+        struct fb_fix_screeninfo fix;
+        if (ioctl(fd, FBIOGET_VSCREENINFO, &var) < 0 ||
+            ioctl(fd, FBIOGET_FSCREENINFO, &fix) < 0 ||
+            var.bits_per_pixel != 8)
+        {
+            close(fd);
+            fd = -1;
+            return;
+        }
+
+        width = var.xres;
+        height = var.yres;
+        stride = fix.line_length;
+        inverted = (var.grayscale == MXCFB_GRAYSCALE_8BIT_INVERTED);
+        fb_size = fix.smem_len;
+
+        void *mem = mmap(NULL, fb_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (mem == MAP_FAILED)
+        {
+            close(fd);
+            fd = -1;
+            return;
+        }
+        fb = static_cast<uint8_t *>(mem);
+    }
+
+    ~EinkPanel()
+    {
+        if (fb)
+            munmap(fb, fb_size);
+        if (fd >= 0)
+            close(fd);
+    }
+
+    // Clip a source rectangle to the visible panel
+    bool clip(int &x, int &y, int &w, int &h, const uint8_t *&src, int src_stride) const
+    {
+        if (x < 0)
+        {
+            src -= x;
+            w += x;
+            x = 0;
+        }
+        if (y < 0)
+        {
+            src -= (size_t)y * src_stride;
+            h += y;
+            y = 0;
+        }
+        if (x + w > width)
+            w = width - x;
+        if (y + h > height)
+            h = height - y;
+        return w > 0 && h > 0;
+    }
+};
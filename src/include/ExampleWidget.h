@@ -3,6 +3,7 @@
 #include <vector>
 #include <algorithm>
 #include <cmath>
+#include "TextStyle.h"
 
 class BatteryWidget
 {
@@ -84,8 +85,8 @@ public:
         frame = gtk_frame_new(NULL);
 
         quote_label = gtk_label_new(NULL);
-        std::string markup = "<span size='11000' style='italic'>" + quote + "</span>";
-        gtk_label_set_markup(GTK_LABEL(quote_label), markup.c_str());
+        quote_style().apply(quote_label);
+        TextStyle::set_text(quote_label, quote.c_str());
 
         gtk_container_add(GTK_CONTAINER(frame), quote_label);
         gtk_widget_show_all(frame);
@@ -95,8 +96,14 @@ public:
 
     void update(const std::string &quote)
     {
-        std::string markup = "<span size='11000' style='italic'>" + quote + "</span>";
-        gtk_label_set_markup(GTK_LABEL(quote_label), markup.c_str());
+        TextStyle::set_text(quote_label, quote.c_str());
+    }
+
+private:
+    static const TextStyle &quote_style()
+    {
+        static const TextStyle style(11000, PANGO_WEIGHT_NORMAL, PANGO_STYLE_ITALIC);
+        return style;
     }
 };
 
@@ -115,13 +122,13 @@ public:
         GtkWidget *vbox = gtk_vbox_new(FALSE, 2);
 
         title_label = gtk_label_new(NULL);
-        std::string title_markup = "<span size='12000' weight='bold'>" + title + "</span>";
-        gtk_label_set_markup(GTK_LABEL(title_label), title_markup.c_str());
+        title_style().apply(title_label);
+        TextStyle::set_text(title_label, title.c_str());
         gtk_box_pack_start(GTK_BOX(vbox), title_label, FALSE, FALSE, 0);
 
         msg_label = gtk_label_new(NULL);
-        std::string msg_markup = "<span size='10000'>" + msg + "</span>";
-        gtk_label_set_markup(GTK_LABEL(msg_label), msg_markup.c_str());
+        msg_style().apply(msg_label);
+        TextStyle::set_text(msg_label, msg.c_str());
         gtk_box_pack_start(GTK_BOX(vbox), msg_label, FALSE, FALSE, 0);
 
         gtk_container_add(GTK_CONTAINER(frame), vbox);
@@ -132,10 +139,20 @@ public:
 
     void update(const std::string &title, const std::string &msg)
     {
-        std::string title_markup = "<span size='12000' weight='bold'>" + title + "</span>";
-        gtk_label_set_markup(GTK_LABEL(title_label), title_markup.c_str());
-        std::string msg_markup = "<span size='10000'>" + msg + "</span>";
-        gtk_label_set_markup(GTK_LABEL(msg_label), msg_markup.c_str());
+        TextStyle::set_text(title_label, title.c_str());
+        TextStyle::set_text(msg_label, msg.c_str());
+    }
+
+private:
+    static const TextStyle &title_style()
+    {
+        static const TextStyle style(12000, PANGO_WEIGHT_BOLD);
+        return style;
+    }
+    static const TextStyle &msg_style()
+    {
+        static const TextStyle style(10000);
+        return style;
     }
 };
 
@@ -151,8 +168,8 @@ public:
         hbox = gtk_hbox_new(FALSE, 5);
 
         track_label = gtk_label_new(NULL);
-        std::string markup = "<span size='11000'>" + track + "</span>";
-        gtk_label_set_markup(GTK_LABEL(track_label), markup.c_str());
+        track_style().apply(track_label);
+        TextStyle::set_text(track_label, track.c_str());
         gtk_box_pack_start(GTK_BOX(hbox), track_label, TRUE, TRUE, 0);
 
         play_button = gtk_button_new_with_label("▶");
@@ -165,7 +182,13 @@ public:
 
     void update(const std::string &track)
     {
-        std::string markup = "<span size='11000'>" + track + "</span>";
-        gtk_label_set_markup(GTK_LABEL(track_label), markup.c_str());
+        TextStyle::set_text(track_label, track.c_str());
+    }
+
+private:
+    static const TextStyle &track_style()
+    {
+        static const TextStyle style(11000);
+        return style;
     }
 };
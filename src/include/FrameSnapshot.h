@@ -0,0 +1,194 @@
+#pragma once
+#include <gtk/gtk.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "EinkPanel.h"
+
+// ----------------- FrameSnapshot -----------------
+// The last fully composed dashboard frame plus one small record per widget
+// (screen rect + state hash), saved after full refreshes. At startup the
+// pixels go straight to the panel before GTK is initialised, and the records
+// tell KindleWindow which widgets actually changed since.
+//
+// File layout: SnapshotHeader, widget_count SnapshotWidget, then
+// width * height 8-bit gray pixels (0 = black).
+
+#pragma pack(push, 1)
+struct SnapshotHeader
+{
+    uint32_t magic; // 'DWF1'
+    uint16_t version;
+    uint16_t widget_count;
+    int16_t origin_x, origin_y; // window position on the panel
+    uint16_t width, height;
+};
+
+struct SnapshotWidget
+{
+    int16_t x, y; // relative to the window
+    uint16_t w, h;
+    uint64_t state_hash;
+};
+#pragma pack(pop)
+
+class FrameSnapshot
+{
+public:
+    static constexpr uint32_t MAGIC = 0x31465744; // "DWF1"
+    static constexpr uint16_t VERSION = 1;
+
+    const SnapshotHeader *header = nullptr;
+    const SnapshotWidget *widgets = nullptr;
+    const uint8_t *pixels = nullptr;
+
+    FrameSnapshot() {}
+    ~FrameSnapshot() { release(); }
+
+    FrameSnapshot(const FrameSnapshot &) = delete;
+    FrameSnapshot &operator=(const FrameSnapshot &) = delete;
+
+    bool is_loaded() const { return header != nullptr; }
+
+    bool load(const std::string &path)
+    {
+        release();
+
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+            return false;
+
+        struct stat st;
+        if (fstat(fd, &st) < 0 || st.st_size < (off_t)sizeof(SnapshotHeader))
+        {
+            close(fd);
+            return false;
+        }
+
+        void *mem = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+        if (mem == MAP_FAILED)
+            return false;
+
+        map = mem;
+        map_size = st.st_size;
+
+        auto *h = static_cast<const SnapshotHeader *>(map);
+        size_t expected = sizeof(SnapshotHeader) + h->widget_count * sizeof(SnapshotWidget) +
+                          (size_t)h->width * h->height;
+        if (h->magic != MAGIC || h->version != VERSION || expected != map_size)
+        {
+            release();
+            return false;
+        }
+
+        header = h;
+        widgets = reinterpret_cast<const SnapshotWidget *>(h + 1);
+        pixels = reinterpret_cast<const uint8_t *>(widgets + h->widget_count);
+        return true;
+    }
+
+    void release()
+    {
+        if (map)
+            munmap(map, map_size);
+        map = nullptr;
+        map_size = 0;
+        header = nullptr;
+        widgets = nullptr;
+        pixels = nullptr;
+    }
+
+    // Called before gtk_init: blit the saved frame and refresh it (no flash)
+    static bool show_on_panel(const std::string &path)
+    {
+        FrameSnapshot snap;
+        if (!snap.load(path))
+            return false;
+
+        EinkPanel &panel = EinkPanel::get();
+        const SnapshotHeader *h = snap.header;
+        if (!panel.blit_gray8(h->origin_x, h->origin_y, h->width, h->height, snap.pixels, h->width))
+            return false;
+        return panel.send_update(h->origin_x, h->origin_y, h->width, h->height,
+                                 EinkPanel::WAVEFORM_GC16, false);
+    }
+
+    // The saved frame as a cairo surface, for painting it inside GTK
+    cairo_surface_t *create_surface() const
+    {
+        if (!is_loaded())
+            return nullptr;
+
+        cairo_surface_t *surface =
+            cairo_image_surface_create(CAIRO_FORMAT_RGB24, header->width, header->height);
+        unsigned char *data = cairo_image_surface_get_data(surface);
+        int stride = cairo_image_surface_get_stride(surface);
+
+        for (int y = 0; y < header->height; y++)
+        {
+            uint32_t *dst = reinterpret_cast<uint32_t *>(data + (size_t)y * stride);
+            const uint8_t *src = pixels + (size_t)y * header->width;
+            for (int x = 0; x < header->width; x++)
+                dst[x] = src[x] * 0x010101u;
+        }
+        cairo_surface_mark_dirty(surface);
+        return surface;
+    }
+
+    // Capture the composed window contents and write them atomically
+    static bool save(const std::string &path, GdkWindow *window,
+                     const std::vector<SnapshotWidget> &records)
+    {
+        int w, h, ox, oy;
+        gdk_drawable_get_size(window, &w, &h);
+        gdk_window_get_origin(window, &ox, &oy);
+
+        GdkPixbuf *pb = gdk_pixbuf_get_from_drawable(NULL, window, NULL, 0, 0, 0, 0, w, h);
+        if (!pb)
+            return false;
+
+        SnapshotHeader header{MAGIC, VERSION, static_cast<uint16_t>(records.size()),
+                              static_cast<int16_t>(ox), static_cast<int16_t>(oy),
+                              static_cast<uint16_t>(w), static_cast<uint16_t>(h)};
+
+        // RGB -> 8-bit luma
+        std::vector<uint8_t> gray((size_t)w * h);
+        const guchar *src = gdk_pixbuf_get_pixels(pb);
+        int rowstride = gdk_pixbuf_get_rowstride(pb);
+        int channels = gdk_pixbuf_get_n_channels(pb);
+        for (int y = 0; y < h; y++)
+        {
+            const guchar *p = src + (size_t)y * rowstride;
+            for (int x = 0; x < w; x++, p += channels)
+                gray[(size_t)y * w + x] = (p[0] * 77 + p[1] * 150 + p[2] * 29) >> 8;
+        }
+        g_object_unref(pb);
+
+        std::string tmp = path + ".tmp";
+        FILE *f = fopen(tmp.c_str(), "wb");
+        if (!f)
+            return false;
+        bool ok = fwrite(&header, sizeof(header), 1, f) == 1 &&
+                  (records.empty() ||
+                   fwrite(records.data(), sizeof(SnapshotWidget), records.size(), f) == records.size()) &&
+                  fwrite(gray.data(), 1, gray.size(), f) == gray.size();
+        ok = (fclose(f) == 0) && ok;
+
+        if (!ok || rename(tmp.c_str(), path.c_str()) != 0)
+        {
+            unlink(tmp.c_str());
+            return false;
+        }
+        return true;
+    }
+
+private:
+    void *map = nullptr;
+    size_t map_size = 0;
+};
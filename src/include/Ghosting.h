@@ -0,0 +1,111 @@
+#pragma once
+#include <stdint.h>
+#include <string.h>
+#include <algorithm>
+#include "EinkPanel.h"
+
+// ----------------- Ghosting -----------------
+// Estimate of the ghosting that partial (non-flashing) refreshes have left
+// on one tile. Each partial refresh adds to the tile's score in proportion to
+// how much of the tile changed. Pixels that moved to or from a mid gray
+// count GRAY_WEIGHT times, since they leave the strongest residue. When the
+// score reaches the tile's threshold, KindleWindow flashes only that tile
+// with a full GC16 update and the score starts over. Tiles that rarely
+// change (quote, weather) are never flashed just because the clock ticked.
+//
+// Changes are measured on a GRID x GRID sample of the framebuffer taken
+// after each batch of exposes. Without a panel (desktop, replay) every
+// refresh counts as a black/white change of the area it exposed.
+struct GhostStats
+{
+    static constexpr int GRID = 16;
+    static constexpr float DEFAULT_THRESHOLD = 10.0f;
+    static constexpr float GRAY_WEIGHT = 3.0f;
+
+    float threshold = 0; // 0: DEFAULT_THRESHOLD, < 0: never flash
+    float score = 0;
+    uint32_t partials = 0;         // partial refreshes accounted
+    uint32_t gray_transitions = 0; // sampled pixels that changed through mid gray
+    uint32_t flashes = 0;          // targeted full refreshes issued
+    uint64_t pending_area = 0;     // pixels exposed since the last account()
+
+    float effective_threshold() const { return threshold == 0 ? DEFAULT_THRESHOLD : threshold; }
+
+    bool over_threshold() const
+    {
+        float t = effective_threshold();
+        return t > 0 && score >= t;
+    }
+
+    // Account the exposes since the last call as one partial refresh of the
+    // w x h tile at panel position (x, y)
+    void account(const EinkPanel &panel, int x, int y, int w, int h)
+    {
+        if (!pending_area || w <= 0 || h <= 0)
+            return;
+        partials++;
+        float coverage = std::min(1.0f, static_cast<float>(pending_area) / (static_cast<float>(w) * h));
+        pending_area = 0;
+
+        uint8_t now[GRID * GRID];
+        if (!sample(panel, x, y, w, h, now))
+        {
+            score += coverage;
+            return;
+        }
+        if (!sampled)
+        {
+            // Nothing to compare against yet
+            memcpy(samples, now, sizeof(samples));
+            sampled = true;
+            score += coverage;
+            return;
+        }
+
+        float change = 0;
+        for (int i = 0; i < GRID * GRID; i++)
+        {
+            if (now[i] == samples[i])
+                continue;
+            if (is_gray(now[i]) || is_gray(samples[i]))
+            {
+                gray_transitions++;
+                change += GRAY_WEIGHT;
+            }
+            else
+                change += 1;
+        }
+        memcpy(samples, now, sizeof(samples));
+        score += change / (GRID * GRID);
+    }
+
+    void flashed()
+    {
+        score = 0;
+        flashes++;
+    }
+
+private:
+    bool sampled = false;
+    uint8_t samples[GRID * GRID];
+
+    static bool is_gray(uint8_t v) { return v > 0x20 && v < 0xE0; }
+
+    static bool sample(const EinkPanel &panel, int x, int y, int w, int h, uint8_t *out)
+    {
+        if (!panel.is_open())
+            return false;
+        for (int j = 0; j < GRID; j++)
+        {
+            int py = y + (2 * j + 1) * h / (2 * GRID);
+            for (int i = 0; i < GRID; i++)
+            {
+                int v = panel.gray_at(x + (2 * i + 1) * w / (2 * GRID), py);
+                if (v < 0)
+                    return false; // tile not fully on the panel
+                out[j * GRID + i] = static_cast<uint8_t>(v);
+            }
+        }
+        return true;
+    }
+};
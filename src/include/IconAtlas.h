@@ -0,0 +1,244 @@
+#pragma once
+#include <gtk/gtk.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+// ----------------- IconAtlas -----------------
+// Square icons keyed by (code, size), pre-rasterized to 4-bit ink coverage
+// (0 = paper, 15 = full ink) and kept in one file that is mmap'ed at
+// startup. A size that is not in the file yet is rasterized once for every
+// code with the draw function and the file is rewritten, so later boots
+// never draw (or look up fonts) again.
+//
+// File layout: IconAtlasHeader, `count` IconAtlasEntry, then pixel rows of
+// (size + 1) / 2 bytes, high nibble first.
+
+#pragma pack(push, 1)
+struct IconAtlasHeader
+{
+    uint32_t magic; // 'DWIA'
+    uint16_t version;
+    uint16_t count;
+};
+
+struct IconAtlasEntry
+{
+    uint16_t code;
+    uint16_t size;
+    uint32_t offset; // from file start
+};
+#pragma pack(pop)
+
+class IconAtlas
+{
+public:
+    static constexpr uint32_t MAGIC = 0x41495744; // "DWIA"
+    static constexpr uint16_t VERSION = 1;
+
+    typedef void (*DrawFunc)(cairo_t *cr, int code, int size);
+
+    // `draw` renders one icon into a size x size A8 surface, for codes
+    // 0 .. code_count - 1. Bump `design_version` when the drawings change.
+    IconAtlas(const std::string &path_, DrawFunc draw_, int code_count_, uint16_t design_version_ = 1)
+        : path(path_), draw(draw_), code_count(code_count_), design_version(design_version_),
+          map(nullptr), map_size(0), writable(true)
+    {
+        load();
+    }
+
+    ~IconAtlas() { unmap(); }
+
+    IconAtlas(const IconAtlas &) = delete;
+    IconAtlas &operator=(const IconAtlas &) = delete;
+
+    // Paint icon (code, size) in the current source colour at x, y
+    void paint(cairo_t *cr, int code, int size, double x, double y)
+    {
+        const uint8_t *px = find(code, size);
+        if (!px && writable && add_size(size))
+            px = find(code, size);
+
+        cairo_surface_t *mask;
+        if (px)
+            mask = expand(px, size);
+        else
+        {
+            // No writable atlas: draw directly this time
+            mask = cairo_image_surface_create(CAIRO_FORMAT_A8, size, size);
+            cairo_t *mcr = cairo_create(mask);
+            draw(mcr, code, size);
+            cairo_destroy(mcr);
+        }
+        cairo_mask_surface(cr, mask, x, y);
+        cairo_surface_destroy(mask);
+    }
+
+private:
+    std::string path;
+    DrawFunc draw;
+    int code_count;
+    uint16_t design_version;
+    void *map;
+    size_t map_size;
+    bool writable; // cleared after a failed rewrite; then icons are drawn
+
+    const IconAtlasHeader *header() const { return static_cast<const IconAtlasHeader *>(map); }
+    const IconAtlasEntry *entries() const { return reinterpret_cast<const IconAtlasEntry *>(header() + 1); }
+
+    static size_t stride(int size) { return (size + 1) / 2; }
+
+    const uint8_t *find(int code, int size) const
+    {
+        if (!map)
+            return nullptr;
+        for (int i = 0; i < header()->count; i++)
+        {
+            if (entries()[i].code == code && entries()[i].size == size)
+                return static_cast<const uint8_t *>(map) + entries()[i].offset;
+        }
+        return nullptr;
+    }
+
+    void unmap()
+    {
+        if (map)
+            munmap(map, map_size);
+        map = nullptr;
+        map_size = 0;
+    }
+
+    // mmap the file; reject it unless every entry lies inside it
+    void load()
+    {
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+            return;
+        struct stat st;
+        if (fstat(fd, &st) < 0 || st.st_size < (off_t)sizeof(IconAtlasHeader))
+        {
+            close(fd);
+            return;
+        }
+        void *mem = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+        if (mem == MAP_FAILED)
+            return;
+        map = mem;
+        map_size = st.st_size;
+
+        const IconAtlasHeader *h = header();
+        bool ok = h->magic == MAGIC && h->version == (VERSION << 8 | design_version) &&
+                  sizeof(IconAtlasHeader) + h->count * sizeof(IconAtlasEntry) <= map_size;
+        for (int i = 0; ok && i < h->count; i++)
+        {
+            const IconAtlasEntry &e = entries()[i];
+            ok = e.offset + stride(e.size) * e.size <= map_size;
+        }
+        if (!ok)
+            unmap();
+    }
+
+    static cairo_surface_t *expand(const uint8_t *px, int size)
+    {
+        cairo_surface_t *mask = cairo_image_surface_create(CAIRO_FORMAT_A8, size, size);
+        cairo_surface_flush(mask);
+        uint8_t *dst = cairo_image_surface_get_data(mask);
+        int dst_stride = cairo_image_surface_get_stride(mask);
+        for (int y = 0; y < size; y++)
+        {
+            const uint8_t *row = px + y * stride(size);
+            for (int x = 0; x < size; x++)
+            {
+                uint8_t v = (x & 1) ? (row[x / 2] & 0x0F) : (row[x / 2] >> 4);
+                dst[y * dst_stride + x] = v * 17;
+            }
+        }
+        cairo_surface_mark_dirty(mask);
+        return mask;
+    }
+
+    void rasterize(int code, int size, std::string &out) const
+    {
+        cairo_surface_t *surface = cairo_image_surface_create(CAIRO_FORMAT_A8, size, size);
+        cairo_t *cr = cairo_create(surface);
+        draw(cr, code, size);
+        cairo_destroy(cr);
+        cairo_surface_flush(surface);
+
+        const uint8_t *src = cairo_image_surface_get_data(surface);
+        int src_stride = cairo_image_surface_get_stride(surface);
+        std::string row(stride(size), '\0');
+        for (int y = 0; y < size; y++)
+        {
+            std::fill(row.begin(), row.end(), '\0');
+            for (int x = 0; x < size; x++)
+            {
+                uint8_t v = (src[y * src_stride + x] + 8) / 17; // round to 0..15
+                row[x / 2] |= (x & 1) ? v : v << 4;
+            }
+            out += row;
+        }
+        cairo_surface_destroy(surface);
+    }
+
+    // Rasterize every code at `size`, rewrite the file (tmp + rename), remap
+    bool add_size(int size)
+    {
+        if (size <= 0 || size > 1024)
+            return false;
+
+        std::vector<IconAtlasEntry> index;
+        std::string pixels;
+        int old_count = map ? header()->count : 0;
+        for (int i = 0; i < old_count; i++)
+        {
+            IconAtlasEntry e = entries()[i];
+            const char *src = static_cast<const char *>(map) + e.offset;
+            e.offset = pixels.size();
+            pixels.append(src, stride(e.size) * e.size);
+            index.push_back(e);
+        }
+        for (int code = 0; code < code_count; code++)
+        {
+            index.push_back({static_cast<uint16_t>(code), static_cast<uint16_t>(size),
+                             static_cast<uint32_t>(pixels.size())});
+            rasterize(code, size, pixels);
+        }
+
+        uint32_t base = sizeof(IconAtlasHeader) + index.size() * sizeof(IconAtlasEntry);
+        for (auto &e : index)
+            e.offset += base;
+
+        IconAtlasHeader h{MAGIC, static_cast<uint16_t>(VERSION << 8 | design_version),
+                          static_cast<uint16_t>(index.size())};
+        std::string tmp = path + ".tmp";
+        FILE *f = fopen(tmp.c_str(), "wb");
+        if (!f)
+        {
+            writable = false;
+            return false;
+        }
+        bool ok = fwrite(&h, sizeof(h), 1, f) == 1 &&
+                  fwrite(index.data(), sizeof(IconAtlasEntry), index.size(), f) == index.size() &&
+                  fwrite(pixels.data(), pixels.size(), 1, f) == 1;
+        ok = (fclose(f) == 0) && ok;
+        if (!ok || rename(tmp.c_str(), path.c_str()) != 0)
+        {
+            unlink(tmp.c_str());
+            writable = false;
+            return false;
+        }
+
+        unmap();
+        load();
+        return find(0, size) != nullptr;
+    }
+};
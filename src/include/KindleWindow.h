@@ -1,8 +1,16 @@
 #pragma once
 #include <gtk/gtk.h>
+#include <gdk/gdkkeysyms.h>
 #include <vector>
 #include <algorithm>
 #include <cmath>
+#include <functional>
+#include <string>
+#include "ModularWidget.h"
+#include "FrameSnapshot.h"
+#include "Layout.h"
+#include "MemoryBudget.h"
+#include "BinLog.h"
 #define BLOCKS_X 4
 #define BLOCKS_Y 4
 #define PADDING 10
@@ -12,9 +20,10 @@ struct WidgetInfo
     GtkWidget *widget;
     int col, row;
     int width_blocks, height_blocks;
+    ModularWidget *modular = nullptr; // null for plain GtkWidgets
 };
 
-class KindleWindow
+class KindleWindow : public MemoryConsumer
 {
 public:
     GtkWidget *window;
@@ -22,24 +31,48 @@ public:
     int screen_width;
     int screen_height;
     bool show_grid_overlay;
+    bool display_active; // false while the screensaver is up
     std::vector<WidgetInfo> widgets;
 
-    KindleWindow(int width, int height) : screen_width(width), screen_height(height)
+    // offscreen: render into a GtkOffscreenWindow that is never shown on the
+    // display (soak/replay tools)
+    KindleWindow(int width, int height, bool offscreen = false)
+        : screen_width(width), screen_height(height), display_active(true),
+          snapshot_surface(nullptr), lazy_idle(0), snapshot_save_id(0),
+          current(0), page_idle(0), press_x(0)
     {
-        window = gtk_window_new(GTK_WINDOW_TOPLEVEL);
+        window = offscreen ? gtk_offscreen_window_new() : gtk_window_new(GTK_WINDOW_TOPLEVEL);
         gtk_window_set_title(GTK_WINDOW(window),
                              "L:A_N:application_ID:org.kindlemodding.example-gtk-application_PC:N");
         gtk_window_set_default_size(GTK_WINDOW(window), width, height);
         gtk_window_set_position(GTK_WINDOW(window), GTK_WIN_POS_CENTER);
         g_signal_connect(window, "destroy", G_CALLBACK(gtk_main_quit), NULL);
 
-        fixed_container = gtk_fixed_new();
+        fixed_container = new_page_fixed();
         gtk_container_add(GTK_CONTAINER(window), fixed_container);
+        pages.resize(1);
+        pages[0].fixed = fixed_container;
 
-        g_signal_connect(G_OBJECT(fixed_container), "expose-event",
-                         G_CALLBACK(on_expose_static), this);
         g_signal_connect(G_OBJECT(window), "configure-event",
                          G_CALLBACK(on_configure_static), this);
+
+        // Page flips: horizontal swipe or the page-turn keys
+        gtk_widget_add_events(window, GDK_BUTTON_PRESS_MASK | GDK_BUTTON_RELEASE_MASK);
+        g_signal_connect(G_OBJECT(window), "button-press-event",
+                         G_CALLBACK(on_button_press_static), this);
+        g_signal_connect(G_OBJECT(window), "button-release-event",
+                         G_CALLBACK(on_button_release_static), this);
+        g_signal_connect(G_OBJECT(window), "key-press-event",
+                         G_CALLBACK(on_key_press_static), this);
+
+        MemoryBudget::get().add(this);
+    }
+
+    ~KindleWindow()
+    {
+        MemoryBudget::get().remove(this);
+        if (ghost_idle)
+            g_source_remove(ghost_idle);
     }
 
     void add_widget_at_grid(GtkWidget *widget, int col, int row,
@@ -58,24 +91,202 @@ public:
 
     void add_widget_at_grid(ModularWidget *modWidget)
     {
-        GtkWidget *widget = modWidget->container;
-        int col = modWidget->col;
-        int row = modWidget->row;
-        int width_blocks = modWidget->width_blocks;
-        int height_blocks = modWidget->height_blocks;
+        attach(modWidget, fixed_container, widgets);
+    }
 
-        col = std::max(1, std::min(col, BLOCKS_X));
-        row = std::max(1, std::min(row, BLOCKS_Y));
-        width_blocks = std::max(1, std::min(width_blocks, BLOCKS_X - col + 1));
-        height_blocks = std::max(1, std::min(height_blocks, BLOCKS_Y - row + 1));
+    void show_all() { gtk_widget_show_all(window); }
 
-        WidgetInfo info{widget, col, row, width_blocks, height_blocks};
-        widgets.push_back(info);
+    // ---------------- Instant-on snapshot ----------------
+    // Load the frame saved by a previous run; until the lazily added widgets
+    // exist, the window paints it so the first GTK frame matches the panel.
+    void enable_snapshot(const std::string &path)
+    {
+        snapshot_path = path;
+        if (snapshot.load(path))
+            snapshot_surface = snapshot.create_surface();
+    }
 
-        update_widget_position(info, true);
+    // Construct a widget from the main loop after the window is up, one per
+    // idle iteration
+    void add_widget_lazily(std::function<ModularWidget *()> factory)
+    {
+        pages[0].factories.push_back(factory); // to rebuild page 0 later
+        lazy_factories.push_back(factory);
+        if (!lazy_idle)
+            lazy_idle = g_idle_add(on_lazy_idle_static, this);
     }
 
-    void show_all() { gtk_widget_show_all(window); }
+    // After a suspend: let every widget catch up in one pass and paint the
+    // result as a single update instead of a burst of late timer redraws
+    void catch_up_after_resume()
+    {
+        if (!display_active)
+            return; // woken while the screen is dark; display_on() catches up
+        GdkWindow *gdk_win = window->window;
+        if (gdk_win)
+            gdk_window_freeze_updates(gdk_win);
+
+        for (auto &info : widgets)
+        {
+            if (info.modular)
+                info.modular->on_resume();
+        }
+        RefreshScheduler::get().flush(); // held-back redraws join this one
+
+        if (gdk_win)
+        {
+            gdk_window_thaw_updates(gdk_win);
+            gdk_window_process_updates(gdk_win, TRUE);
+        }
+        BINLOG("[RESUME] caught up %zu widgets", widgets.size());
+    }
+
+    // Screensaver / screen off: widgets stop their timers and nothing is
+    // painted until display_on()
+    void display_off()
+    {
+        if (!display_active)
+            return;
+        display_active = false;
+        for (auto &info : widgets)
+        {
+            if (info.modular)
+                info.modular->on_display_off();
+        }
+        if (window->window)
+            gdk_window_freeze_updates(window->window);
+    }
+
+    // Visible again: restart everything with one catch-up render
+    void display_on()
+    {
+        if (display_active)
+            return;
+        display_active = true;
+        if (window->window)
+            gdk_window_thaw_updates(window->window); // catch-up freezes again
+        catch_up_after_resume();
+    }
+
+    // Queue every widget of a layout file for lazy construction
+    bool load_layout(const std::string &path)
+    {
+        if (!layout.load(path))
+            return false;
+        BINLOG("[LAYOUT] %zu widgets from %s%s", layout.size(), path.c_str(),
+                layout.from_cache ? " (cached)" : "");
+        for (size_t i = 0; i < layout.size(); i++)
+        {
+            auto factory = [this, i] { return layout.create(i); };
+            if (layout.page_of(i) == 0)
+                add_widget_lazily(factory);
+            else
+                add_page_widget(layout.page_of(i), factory);
+        }
+        return true;
+    }
+
+    // ---------------- Pages ----------------
+    // Page 0 is built at startup. Other pages are built when shown, or ahead
+    // of time as a neighbour of the current page: neighbours are kept built
+    // with their timers stopped plus a pre-rendered frame, so a flip paints
+    // at once. Pages further away are destroyed and their memory returned.
+    void add_page_widget(size_t page, std::function<ModularWidget *()> factory)
+    {
+        if (page >= pages.size())
+            pages.resize(page + 1);
+        pages[page].factories.push_back(factory);
+    }
+
+    size_t page_count() const { return pages.size(); }
+    size_t current_page() const { return current; }
+
+    void show_page(size_t index)
+    {
+        if (index >= pages.size() || index == current || lazy_idle)
+            return;
+
+        Page &out = pages[current];
+        Page &in = pages[index];
+        if (!in.fixed)
+            build_hidden_page(index);
+
+        // Outgoing page: keep its last frame while the screen still shows it
+        set_surface(out, capture_surface(window->window));
+
+        // Instant feedback: the pre-rendered frame goes out before any work
+        if (in.surface && window->window)
+        {
+            cairo_t *cr = gdk_cairo_create(window->window);
+            cairo_set_source_surface(cr, in.surface, 0, 0);
+            cairo_paint(cr);
+            cairo_destroy(cr);
+            gdk_flush();
+        }
+
+        // Stop the outgoing page's timers and park it
+        for (auto &info : widgets)
+        {
+            if (info.modular)
+                info.modular->on_display_off();
+        }
+        if (!out.offscreen)
+        {
+            out.offscreen = new_page_window();
+            gtk_widget_show(out.offscreen);
+        }
+        gtk_widget_reparent(fixed_container, out.offscreen);
+        out.widgets.swap(widgets);
+
+        // Incoming page: widgets catch up from wall time, painted once
+        gtk_widget_reparent(in.fixed, window);
+        fixed_container = in.fixed;
+        widgets.swap(in.widgets);
+        current = index;
+        BINLOG("[PAGE] showing page %zu of %zu", current + 1, pages.size());
+        catch_up_after_resume();
+
+        prebuild = true;
+        schedule_page_upkeep();
+        MemoryBudget::get().grew();
+    }
+
+    // ---------------- MemoryConsumer ----------------
+    // Pre-rendered frames and hidden pages. The current page's frame is
+    // stale once it is shown and goes first; a hidden page is valued by
+    // what building it took. The snapshot is counted but never dropped.
+    const char *memory_name() const override { return "pages"; }
+
+    size_t memory_bytes() const override
+    {
+        size_t total = MemoryBudget::surface_bytes(snapshot_surface);
+        for (size_t i = 0; i < pages.size(); i++)
+            total += page_bytes(i);
+        return total;
+    }
+
+    bool memory_cheapest(double *cost_per_kb) const override
+    {
+        size_t i = cheapest_page(cost_per_kb);
+        return i < pages.size();
+    }
+
+    size_t memory_evict() override
+    {
+        double cost;
+        size_t i = cheapest_page(&cost);
+        if (i >= pages.size())
+            return 0;
+        size_t before = page_bytes(i);
+        if (i == current)
+            set_surface(pages[i], nullptr);
+        else
+        {
+            unload_page(i);
+            prebuild = false; // until the next flip
+        }
+        return before - page_bytes(i);
+    }
 
     void set_grid_overlay(bool enable)
     {
@@ -91,6 +302,22 @@ private:
 
     gboolean on_expose(GtkWidget *widget, GdkEventExpose *event)
     {
+        if (snapshot_surface)
+        {
+            // Stand-in for widgets that are not constructed yet
+            cairo_t *cr = gdk_cairo_create(widget->window);
+            cairo_set_source_surface(cr, snapshot_surface, 0, 0);
+            gdk_cairo_rectangle(cr, &event->area);
+            cairo_fill(cr);
+            cairo_destroy(cr);
+        }
+        else if (widget == fixed_container && !snapshot_path.empty() && !lazy_idle && current == 0 &&
+                 event->area.width >= screen_width &&
+                 event->area.height >= screen_height)
+        {
+            schedule_snapshot_save();
+        }
+
         if (!show_grid_overlay)
             return FALSE; // skip drawing overlay
         cairo_t *cr = gdk_cairo_create(widget->window);
@@ -137,21 +364,438 @@ private:
         return FALSE;
     }
 
-    void update_widget_position(WidgetInfo &info, bool first_time = false)
+    void update_widget_position(WidgetInfo &info, bool first_time = false,
+                                GtkWidget *fixed = nullptr)
+    {
+        GdkRectangle r = grid_rect(info);
+        if (!fixed)
+            fixed = fixed_container;
+
+        gtk_widget_set_size_request(info.widget, r.width, r.height);
+
+        if (first_time)
+            gtk_fixed_put(GTK_FIXED(fixed), info.widget, r.x, r.y);
+        else
+            gtk_fixed_move(GTK_FIXED(fixed), info.widget, r.x, r.y);
+    }
+
+    // ---------------- Instant-on snapshot ----------------
+    FrameSnapshot snapshot;
+    std::string snapshot_path;
+    cairo_surface_t *snapshot_surface;
+    std::vector<std::function<ModularWidget *()>> lazy_factories;
+    size_t lazy_next = 0;
+    Layout layout;
+    guint lazy_idle;
+    guint snapshot_save_id;
+
+    // ---------------- Pages ----------------
+    struct Page
+    {
+        std::vector<std::function<ModularWidget *()>> factories;
+        std::vector<int> trace_ids;         // reused when the page is rebuilt
+        GtkWidget *fixed = nullptr;         // null while unloaded
+        GtkWidget *offscreen = nullptr;     // parent of `fixed` while hidden
+        std::vector<WidgetInfo> widgets;    // while hidden
+        cairo_surface_t *surface = nullptr; // pre-rendered frame
+        int64_t build_us = 0;               // last build_hidden_page()
+    };
+    std::vector<Page> pages;
+    size_t current;
+    guint page_idle;
+    double press_x;
+    bool prebuild = true; // false after memory was taken back from neighbours
+    guint ghost_idle = 0;
+
+    // Frame plus, while hidden, the offscreen window's backing pixmap
+    size_t page_bytes(size_t i) const
+    {
+        const Page &p = pages[i];
+        size_t total = MemoryBudget::surface_bytes(p.surface);
+        if (i != current && p.fixed)
+            total += static_cast<size_t>(screen_width) * screen_height * 4;
+        return total;
+    }
+
+    // Page whose memory is cheapest to rebuild, pages.size() if none
+    size_t cheapest_page(double *cost_per_kb) const
+    {
+        size_t best = pages.size();
+        if (lazy_idle)
+            return best; // page 0 is still being built
+        for (size_t i = 0; i < pages.size(); i++)
+        {
+            size_t bytes = page_bytes(i);
+            if (!bytes)
+                continue;
+            double cost = i == current ? 0.0 : static_cast<double>(pages[i].build_us) * 1024 / bytes;
+            if (best == pages.size() || cost < *cost_per_kb)
+            {
+                best = i;
+                *cost_per_kb = cost;
+            }
+        }
+        return best;
+    }
+
+    GtkWidget *new_page_fixed()
+    {
+        GtkWidget *fixed = gtk_fixed_new();
+        g_signal_connect(G_OBJECT(fixed), "expose-event",
+                         G_CALLBACK(on_expose_static), this);
+        return fixed;
+    }
+
+    GtkWidget *new_page_window()
+    {
+        GtkWidget *w = gtk_offscreen_window_new();
+        gtk_window_set_default_size(GTK_WINDOW(w), screen_width, screen_height);
+        return w;
+    }
+
+    void attach(ModularWidget *modWidget, GtkWidget *fixed, std::vector<WidgetInfo> &list)
+    {
+        if (!modWidget->trace_id)
+            modWidget->trace_id = Trace::register_widget(modWidget->type_name());
+        modWidget->restore_persisted_state();
+
+        GtkWidget *widget = modWidget->container;
+        int col = modWidget->col;
+        int row = modWidget->row;
+        int width_blocks = modWidget->width_blocks;
+        int height_blocks = modWidget->height_blocks;
+
+        col = std::max(1, std::min(col, BLOCKS_X));
+        row = std::max(1, std::min(row, BLOCKS_Y));
+        width_blocks = std::max(1, std::min(width_blocks, BLOCKS_X - col + 1));
+        height_blocks = std::max(1, std::min(height_blocks, BLOCKS_Y - row + 1));
+
+        WidgetInfo info{widget, col, row, width_blocks, height_blocks, modWidget};
+        list.push_back(info);
+
+        update_widget_position(info, true, fixed);
+
+        g_signal_connect(G_OBJECT(modWidget->gtkWidget), "event-after",
+                         G_CALLBACK(on_widget_event_after_static), this);
+    }
+
+    // ---------------- Ghosting ----------------
+    // Exposes of the shown page are the partial refreshes the panel gets.
+    // They are accounted per tile once the batch is drawn; a tile whose
+    // ghosting estimate crossed its threshold is flashed on its own.
+    static void on_widget_event_after_static(GtkWidget *widget, GdkEvent *event, gpointer data)
+    {
+        if (event->type == GDK_EXPOSE)
+            static_cast<KindleWindow *>(data)->on_widget_exposed(widget, event->expose.area);
+    }
+
+    void on_widget_exposed(GtkWidget *widget, const GdkRectangle &area)
+    {
+        if (!display_active)
+            return;
+        for (auto &info : widgets)
+        {
+            if (info.modular && info.modular->gtkWidget == widget)
+            {
+                info.modular->ghost.pending_area += static_cast<uint64_t>(area.width) * area.height;
+                if (!ghost_idle)
+                    ghost_idle = g_idle_add_full(G_PRIORITY_LOW, on_ghost_idle_static, this, NULL);
+                return;
+            }
+        }
+        // not on the shown page: nothing reached the panel
+    }
+
+    static gboolean on_ghost_idle_static(gpointer data)
+    {
+        auto *self = static_cast<KindleWindow *>(data);
+        self->ghost_idle = 0;
+        self->account_ghosting();
+        return FALSE;
+    }
+
+    void account_ghosting()
+    {
+        if (!window->window)
+            return;
+        gdk_flush(); // the X server has drawn the batch into the framebuffer
+        int ox, oy;
+        gdk_window_get_origin(window->window, &ox, &oy);
+
+        EinkPanel &panel = EinkPanel::get();
+        for (auto &info : widgets)
+        {
+            if (!info.modular || !info.modular->ghost.pending_area)
+                continue;
+            GhostStats &ghost = info.modular->ghost;
+            GdkRectangle r = grid_rect(info);
+            ghost.account(panel, ox + r.x, oy + r.y, r.width, r.height);
+            if (!ghost.over_threshold())
+                continue;
+            BINLOG("[GHOST] flashing %s (score %.1f)", info.modular->type_name(), ghost.score);
+            panel.send_update(ox + r.x, oy + r.y, r.width, r.height, EinkPanel::WAVEFORM_GC16, true);
+            ghost.flashed();
+        }
+    }
+
+    // Construct a page inside its own offscreen window, render it once and
+    // stop its timers
+    void build_hidden_page(size_t index)
+    {
+        int64_t start = Trace::now_us();
+        Page &p = pages[index];
+        p.offscreen = new_page_window();
+        p.fixed = new_page_fixed();
+        gtk_container_add(GTK_CONTAINER(p.offscreen), p.fixed);
+
+        p.trace_ids.resize(p.factories.size(), 0);
+        for (size_t k = 0; k < p.factories.size(); k++)
+        {
+            ModularWidget *mw = p.factories[k]();
+            if (!mw)
+                continue;
+            mw->page = static_cast<int>(index);
+            mw->trace_id = p.trace_ids[k];
+            attach(mw, p.fixed, p.widgets);
+            p.trace_ids[k] = mw->trace_id;
+        }
+        gtk_widget_show_all(p.offscreen);
+
+        for (auto &info : p.widgets)
+            info.modular->on_display_off();
+
+        gdk_window_process_updates(p.offscreen->window, TRUE);
+        GdkPixbuf *pixbuf = gtk_offscreen_window_get_pixbuf(GTK_OFFSCREEN_WINDOW(p.offscreen));
+        set_surface(p, pixbuf_to_surface(pixbuf));
+        if (pixbuf)
+            g_object_unref(pixbuf);
+        p.build_us = Trace::now_us() - start;
+    }
+
+    // Destroy a hidden page; its factories rebuild it when needed again
+    void unload_page(size_t index)
+    {
+        Page &p = pages[index];
+        if (!p.offscreen)
+            return;
+        gtk_widget_destroy(p.offscreen); // takes `fixed` and every widget
+        for (auto &info : p.widgets)
+            delete info.modular;
+        p.widgets.clear();
+        p.widgets.shrink_to_fit();
+        p.offscreen = nullptr;
+        p.fixed = nullptr;
+        set_surface(p, nullptr);
+    }
+
+    static void set_surface(Page &p, cairo_surface_t *surface)
+    {
+        if (p.surface)
+            cairo_surface_destroy(p.surface);
+        p.surface = surface;
+    }
+
+    static cairo_surface_t *pixbuf_to_surface(GdkPixbuf *pixbuf)
+    {
+        if (!pixbuf)
+            return nullptr;
+        cairo_surface_t *surface = cairo_image_surface_create(
+            CAIRO_FORMAT_RGB24, gdk_pixbuf_get_width(pixbuf), gdk_pixbuf_get_height(pixbuf));
+        cairo_t *cr = cairo_create(surface);
+        gdk_cairo_set_source_pixbuf(cr, pixbuf, 0, 0);
+        cairo_paint(cr);
+        cairo_destroy(cr);
+        return surface;
+    }
+
+    cairo_surface_t *capture_surface(GdkWindow *gdk_win)
+    {
+        if (!gdk_win)
+            return nullptr;
+        GdkPixbuf *pixbuf = gdk_pixbuf_get_from_drawable(NULL, gdk_win, NULL, 0, 0, 0, 0,
+                                                         screen_width, screen_height);
+        cairo_surface_t *surface = pixbuf_to_surface(pixbuf);
+        if (pixbuf)
+            g_object_unref(pixbuf);
+        return surface;
+    }
+
+    // Unload far pages now, build missing neighbours one per idle iteration
+    void schedule_page_upkeep()
+    {
+        if (pages.size() > 1 && !page_idle)
+            page_idle = g_idle_add(on_page_idle_static, this);
+    }
+
+    static gboolean on_page_idle_static(gpointer data)
+    {
+        return static_cast<KindleWindow *>(data)->on_page_idle();
+    }
+
+    gboolean on_page_idle()
+    {
+        for (size_t i = 0; i < pages.size(); i++)
+        {
+            if (i + 1 < current || i > current + 1)
+                unload_page(i);
+        }
+
+        for (size_t i : {current + 1, current - 1})
+        {
+            if (prebuild && i < pages.size() && !pages[i].fixed)
+            {
+                build_hidden_page(i);
+                MemoryBudget::get().grew();
+                return TRUE; // the other neighbour next time
+            }
+        }
+
+        page_idle = 0;
+        return FALSE;
+    }
+
+    static gboolean on_button_press_static(GtkWidget *widget, GdkEventButton *event, gpointer data)
+    {
+        static_cast<KindleWindow *>(data)->press_x = event->x_root;
+        return FALSE;
+    }
+
+    static gboolean on_button_release_static(GtkWidget *widget, GdkEventButton *event, gpointer data)
+    {
+        auto *self = static_cast<KindleWindow *>(data);
+        double dx = event->x_root - self->press_x;
+        if (std::fabs(dx) < self->screen_width / 4.0)
+            return FALSE;
+        // Swipe left: next page
+        if (dx < 0)
+            self->show_page(self->current + 1);
+        else if (self->current > 0)
+            self->show_page(self->current - 1);
+        return TRUE;
+    }
+
+    static gboolean on_key_press_static(GtkWidget *widget, GdkEventKey *event, gpointer data)
+    {
+        auto *self = static_cast<KindleWindow *>(data);
+        switch (event->keyval)
+        {
+        case GDK_Page_Down:
+        case GDK_Right:
+            self->show_page(self->current + 1);
+            return TRUE;
+        case GDK_Page_Up:
+        case GDK_Left:
+            if (self->current > 0)
+                self->show_page(self->current - 1);
+            return TRUE;
+        }
+        return FALSE;
+    }
+
+    GdkRectangle grid_rect(const WidgetInfo &info) const
     {
         double block_width = static_cast<double>(screen_width) / BLOCKS_X;
         double block_height = static_cast<double>(screen_height) / BLOCKS_Y;
 
-        int x = (info.col - 1) * block_width + PADDING;
-        int y = (info.row - 1) * block_height + PADDING;
-        int w = info.width_blocks * block_width - 2 * PADDING;
-        int h = info.height_blocks * block_height - 2 * PADDING;
+        GdkRectangle r;
+        r.x = (info.col - 1) * block_width + PADDING;
+        r.y = (info.row - 1) * block_height + PADDING;
+        r.width = info.width_blocks * block_width - 2 * PADDING;
+        r.height = info.height_blocks * block_height - 2 * PADDING;
+        return r;
+    }
 
-        gtk_widget_set_size_request(info.widget, w, h);
+    static gboolean on_lazy_idle_static(gpointer data)
+    {
+        return static_cast<KindleWindow *>(data)->on_lazy_idle();
+    }
 
-        if (first_time)
-            gtk_fixed_put(GTK_FIXED(fixed_container), info.widget, x, y);
-        else
-            gtk_fixed_move(GTK_FIXED(fixed_container), info.widget, x, y);
+    gboolean on_lazy_idle()
+    {
+        if (lazy_next < lazy_factories.size())
+        {
+            ModularWidget *mw = lazy_factories[lazy_next++]();
+            if (mw) // null when the type's plugin is missing
+            {
+                add_widget_at_grid(mw);
+                gtk_widget_show_all(mw->container);
+            }
+            return TRUE;
+        }
+
+        lazy_idle = 0;
+        lazy_factories.clear();
+        if (pages.size() == 1)
+            layout.release(); // other pages still create from it
+        reconcile_snapshot();
+        schedule_page_upkeep();
+        return FALSE;
+    }
+
+    // Compare the constructed widgets against the saved records. Unchanged
+    // widgets draw the same pixels the panel already shows, so only the
+    // changed regions are sent to the e-ink controller.
+    void reconcile_snapshot()
+    {
+        if (!snapshot.is_loaded())
+            return;
+
+        const SnapshotHeader *h = snapshot.header;
+        EinkPanel &panel = EinkPanel::get();
+        size_t i = 0;
+        int changed = 0;
+
+        gdk_window_process_updates(window->window, TRUE);
+        for (auto &info : widgets)
+        {
+            if (!info.modular)
+                continue;
+
+            GdkRectangle r = grid_rect(info);
+            uint64_t hash = info.modular->state_hash();
+            bool same = i < h->widget_count && hash != 0 &&
+                        snapshot.widgets[i].state_hash == hash &&
+                        snapshot.widgets[i].x == r.x && snapshot.widgets[i].y == r.y;
+            i++;
+            if (same)
+                continue;
+
+            changed++;
+            panel.send_update(h->origin_x + r.x, h->origin_y + r.y, r.width, r.height,
+                              EinkPanel::WAVEFORM_GC16, false);
+        }
+        BINLOG("[SNAPSHOT] %d of %zu widgets changed since last run", changed, i);
+
+        cairo_surface_destroy(snapshot_surface);
+        snapshot_surface = nullptr;
+        snapshot.release();
+    }
+
+    // Debounced: a burst of full exposes of the startup page writes the file once
+    void schedule_snapshot_save()
+    {
+        if (!snapshot_save_id)
+            snapshot_save_id = Clock::get()->add_timeout(2000, on_snapshot_save_static, this);
+    }
+
+    static gboolean on_snapshot_save_static(gpointer data)
+    {
+        auto *self = static_cast<KindleWindow *>(data);
+        self->snapshot_save_id = 0;
+        if (self->current != 0)
+            return FALSE; // the snapshot is the startup page; flipped away meanwhile
+
+        std::vector<SnapshotWidget> records;
+        for (auto &info : self->widgets)
+        {
+            if (!info.modular)
+                continue;
+            GdkRectangle r = self->grid_rect(info);
+            records.push_back({static_cast<int16_t>(r.x), static_cast<int16_t>(r.y),
+                               static_cast<uint16_t>(r.width), static_cast<uint16_t>(r.height),
+                               info.modular->state_hash()});
+        }
+        FrameSnapshot::save(self->snapshot_path, self->window->window, records);
+        return FALSE;
     }
-};
\ No newline at end of file
+};
@@ -0,0 +1,415 @@
+#pragma once
+#include <gtk/gtk.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "WidgetRegistry.h"
+#include "BinLog.h"
+
+// ----------------- Layout -----------------
+// Dashboard description in a text file, one widget per line:
+//
+//   # type            col row w h  parameters
+//   SpeakerGrill        1   1  4 1  radius=16
+//   QuoteWidget         1   4  4 1  text="Stay hungry, stay foolish."
+//   page
+//   BatteryWidget       1   1  2 2
+//
+// A line holding just `page` starts the next dashboard page.
+//
+// The first load validates it and compiles it to `<source>.cache` (layout
+// below). Later boots only stat the source: if size and mtime match the
+// cache header, the cache is mmap'ed and widgets are built straight from it.
+// A changed mtime with identical content (hash) keeps the cache as well.
+//
+// Cache layout: LayoutCacheHeader, entry_count LayoutCacheEntry,
+// param_count LayoutCacheParam, then string_bytes of NUL-terminated strings
+// (offsets below point into that table).
+
+#pragma pack(push, 1)
+struct LayoutCacheHeader
+{
+    uint32_t magic; // 'DWLC'
+    uint16_t version;
+    uint16_t entry_count;
+    int64_t source_mtime;
+    int64_t source_size;
+    uint64_t source_hash;
+    uint32_t param_count;
+    uint32_t string_bytes;
+};
+
+struct LayoutCacheEntry
+{
+    uint32_t type; // string offset
+    uint8_t col, row;
+    uint8_t width_blocks, height_blocks;
+    uint8_t page;
+    uint16_t first_param;
+    uint16_t param_count;
+};
+
+struct LayoutCacheParam
+{
+    uint32_t key, value; // string offsets
+};
+#pragma pack(pop)
+
+class Layout
+{
+public:
+    static constexpr uint32_t MAGIC = 0x434C5744; // "DWLC"
+    static constexpr uint16_t VERSION = 2;
+    static constexpr int MAX_SPAN = 16;
+
+    bool from_cache = false; // last load() skipped parsing
+
+    Layout() : map(nullptr), map_size(0) {}
+    ~Layout() { release(); }
+
+    Layout(const Layout &) = delete;
+    Layout &operator=(const Layout &) = delete;
+
+    // Load `path`, through its cache when still valid
+    bool load(const std::string &path)
+    {
+        release();
+        from_cache = false;
+
+        struct stat st;
+        if (stat(path.c_str(), &st) < 0)
+        {
+            BINLOG("[LAYOUT] stat %s failed, errno %d", path.c_str(), errno);
+            return false;
+        }
+
+        std::string cache_path = path + ".cache";
+        if (map_cache(cache_path))
+        {
+            const LayoutCacheHeader *h = header();
+            if (h->source_size == st.st_size && h->source_mtime == (int64_t)st.st_mtime)
+            {
+                from_cache = true;
+                return true;
+            }
+        }
+
+        std::string text;
+        if (!read_file(path, text))
+        {
+            release();
+            return false;
+        }
+        uint64_t hash = ModularWidget::hash_bytes(text.data(), text.size());
+
+        // Only touched: keep the cache, just record the new mtime
+        if (map && header()->source_hash == hash && header()->source_size == st.st_size)
+        {
+            LayoutCacheHeader h = *header();
+            h.source_mtime = st.st_mtime;
+            int fd = open(cache_path.c_str(), O_WRONLY);
+            if (fd >= 0)
+            {
+                ssize_t n = pwrite(fd, &h, sizeof(h), 0);
+                (void)n;
+                close(fd);
+            }
+            from_cache = true;
+            return true;
+        }
+        release();
+
+        owned = compile(path, text, st, hash);
+        if (owned.empty())
+            return false;
+        save(cache_path);
+        return true;
+    }
+
+    size_t size() const { return image() ? header()->entry_count : 0; }
+
+    size_t page_of(size_t i) const { return entries()[i].page; }
+
+    size_t page_count() const
+    {
+        return size() ? page_of(size() - 1) + 1 : 0;
+    }
+
+    // Build widget `i` through the registry (null if its type is unknown)
+    ModularWidget *create(size_t i) const
+    {
+        const LayoutCacheEntry &e = entries()[i];
+        std::vector<const char *> keys, values;
+        for (int p = 0; p < e.param_count; p++)
+        {
+            const LayoutCacheParam &param = params()[e.first_param + p];
+            keys.push_back(str(param.key));
+            values.push_back(str(param.value));
+        }
+        WidgetParams wp{e.col, e.row, e.width_blocks, e.height_blocks, e.param_count,
+                        keys.data(), values.data()};
+        return WidgetRegistry::get().create(str(e.type), wp);
+    }
+
+    // Drop the mapping / compiled image once all widgets are built
+    void release()
+    {
+        if (map)
+            munmap(map, map_size);
+        map = nullptr;
+        map_size = 0;
+        owned.clear();
+        owned.shrink_to_fit();
+    }
+
+private:
+    void *map;
+    size_t map_size;
+    std::string owned; // freshly compiled image (when not mapped)
+
+    const char *image() const
+    {
+        if (map)
+            return static_cast<const char *>(map);
+        return owned.empty() ? nullptr : owned.data();
+    }
+    const LayoutCacheHeader *header() const
+    {
+        return reinterpret_cast<const LayoutCacheHeader *>(image());
+    }
+    const LayoutCacheEntry *entries() const
+    {
+        return reinterpret_cast<const LayoutCacheEntry *>(image() + sizeof(LayoutCacheHeader));
+    }
+    const LayoutCacheParam *params() const
+    {
+        return reinterpret_cast<const LayoutCacheParam *>(entries() + header()->entry_count);
+    }
+    const char *str(uint32_t offset) const
+    {
+        return reinterpret_cast<const char *>(params() + header()->param_count) + offset;
+    }
+
+    static bool read_file(const std::string &path, std::string &out)
+    {
+        gchar *data;
+        gsize len;
+        if (!g_file_get_contents(path.c_str(), &data, &len, NULL))
+            return false;
+        out.assign(data, len);
+        g_free(data);
+        return true;
+    }
+
+    // mmap the cache and check that every offset stays inside it
+    bool map_cache(const std::string &cache_path)
+    {
+        int fd = open(cache_path.c_str(), O_RDONLY);
+        if (fd < 0)
+            return false;
+        struct stat st;
+        if (fstat(fd, &st) < 0 || st.st_size < (off_t)sizeof(LayoutCacheHeader))
+        {
+            close(fd);
+            return false;
+        }
+        void *mem = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+        if (mem == MAP_FAILED)
+            return false;
+        map = mem;
+        map_size = st.st_size;
+
+        const LayoutCacheHeader *h = header();
+        size_t expected = sizeof(LayoutCacheHeader) + h->entry_count * sizeof(LayoutCacheEntry) +
+                          (size_t)h->param_count * sizeof(LayoutCacheParam) + h->string_bytes;
+        bool ok = h->magic == MAGIC && h->version == VERSION && expected == map_size &&
+                  (h->string_bytes == 0 || str(0)[h->string_bytes - 1] == '\0');
+        for (size_t i = 0; ok && i < h->entry_count; i++)
+        {
+            const LayoutCacheEntry &e = entries()[i];
+            int prev_page = i ? entries()[i - 1].page : 0;
+            ok = e.type < h->string_bytes &&
+                 (size_t)e.first_param + e.param_count <= h->param_count &&
+                 (e.page == prev_page || e.page == prev_page + 1);
+        }
+        for (size_t i = 0; ok && i < h->param_count; i++)
+            ok = params()[i].key < h->string_bytes && params()[i].value < h->string_bytes;
+
+        if (!ok)
+            release();
+        return ok;
+    }
+
+    // Split a line into words; "quoted text" (with \" and \\) is one word,
+    // also after key=. A # outside quotes starts a comment.
+    static bool tokenize(const std::string &line, std::vector<std::string> &words)
+    {
+        size_t i = 0;
+        while (i < line.size())
+        {
+            while (i < line.size() && isspace((unsigned char)line[i]))
+                i++;
+            if (i >= line.size() || line[i] == '#')
+                break;
+
+            std::string word;
+            while (i < line.size() && !isspace((unsigned char)line[i]))
+            {
+                if (line[i] != '"')
+                {
+                    word += line[i++];
+                    continue;
+                }
+                for (i++; i < line.size() && line[i] != '"'; i++)
+                {
+                    if (line[i] == '\\' && i + 1 < line.size())
+                        i++;
+                    word += line[i];
+                }
+                if (i >= line.size())
+                    return false; // unterminated quote
+                i++;
+            }
+            words.push_back(word);
+        }
+        return true;
+    }
+
+    static bool is_identifier(const std::string &s)
+    {
+        if (s.empty())
+            return false;
+        for (char c : s)
+        {
+            if (!isalnum((unsigned char)c) && c != '_' && c != '-')
+                return false;
+        }
+        return true;
+    }
+
+    static bool parse_span(const std::string &s, uint8_t *out)
+    {
+        char *end;
+        long v = strtol(s.c_str(), &end, 10);
+        if (s.empty() || *end || v < 1 || v > MAX_SPAN)
+            return false;
+        *out = static_cast<uint8_t>(v);
+        return true;
+    }
+
+    // Parse + validate into a cache image; invalid lines are reported and
+    // skipped
+    static std::string compile(const std::string &path, const std::string &text,
+                               const struct stat &st, uint64_t hash)
+    {
+        std::vector<LayoutCacheEntry> out_entries;
+        std::vector<LayoutCacheParam> out_params;
+        std::string strings;
+        auto intern = [&strings](const std::string &s) {
+            uint32_t off = strings.size();
+            strings.append(s.c_str(), s.size() + 1);
+            return off;
+        };
+
+        int line_no = 0;
+        int page = 0;
+        size_t pos = 0;
+        while (pos < text.size())
+        {
+            size_t nl = text.find('\n', pos);
+            std::string line = text.substr(pos, nl == std::string::npos ? std::string::npos : nl - pos);
+            pos = nl == std::string::npos ? text.size() : nl + 1;
+            line_no++;
+
+            std::vector<std::string> words;
+            const char *error = nullptr;
+            LayoutCacheEntry e{};
+            if (!tokenize(line, words))
+                error = "unterminated quote";
+            else if (words.empty())
+                continue;
+            else if (words.size() == 1 && words[0] == "page")
+            {
+                if (!out_entries.empty() && out_entries.back().page == page)
+                    page++;
+                if (page > 255)
+                    error = "too many pages";
+                else
+                    continue;
+            }
+            else if (words.size() < 5)
+                error = "expected: type col row width height [key=value...]";
+            else if (!is_identifier(words[0]))
+                error = "bad widget type";
+            else if (!parse_span(words[1], &e.col) || !parse_span(words[2], &e.row) ||
+                     !parse_span(words[3], &e.width_blocks) || !parse_span(words[4], &e.height_blocks))
+                error = "grid values must be 1..16";
+
+            std::vector<LayoutCacheParam> line_params;
+            for (size_t w = 5; !error && w < words.size(); w++)
+            {
+                size_t eq = words[w].find('=');
+                if (eq == std::string::npos || !is_identifier(words[w].substr(0, eq)))
+                {
+                    error = "parameters must be key=value";
+                    break;
+                }
+                line_params.push_back({intern(words[w].substr(0, eq)), intern(words[w].substr(eq + 1))});
+            }
+
+            if (error)
+            {
+                BINLOG("[LAYOUT] %s:%d: %s", path.c_str(), line_no, error);
+                continue;
+            }
+
+            e.type = intern(words[0]);
+            e.page = static_cast<uint8_t>(page);
+            e.first_param = static_cast<uint16_t>(out_params.size());
+            e.param_count = static_cast<uint16_t>(line_params.size());
+            out_params.insert(out_params.end(), line_params.begin(), line_params.end());
+            out_entries.push_back(e);
+        }
+
+        if (out_entries.empty())
+        {
+            BINLOG("[LAYOUT] %s: no widgets", path.c_str());
+            return std::string();
+        }
+
+        LayoutCacheHeader h{MAGIC, VERSION, static_cast<uint16_t>(out_entries.size()),
+                            (int64_t)st.st_mtime, (int64_t)st.st_size, hash,
+                            static_cast<uint32_t>(out_params.size()),
+                            static_cast<uint32_t>(strings.size())};
+        std::string img(reinterpret_cast<const char *>(&h), sizeof(h));
+        img.append(reinterpret_cast<const char *>(out_entries.data()),
+                   out_entries.size() * sizeof(LayoutCacheEntry));
+        img.append(reinterpret_cast<const char *>(out_params.data()),
+                   out_params.size() * sizeof(LayoutCacheParam));
+        img += strings;
+        return img;
+    }
+
+    // Atomic replace; a read-only source directory just means no cache
+    void save(const std::string &cache_path) const
+    {
+        std::string tmp = cache_path + ".tmp";
+        FILE *f = fopen(tmp.c_str(), "wb");
+        if (!f)
+            return;
+        bool ok = fwrite(owned.data(), owned.size(), 1, f) == 1;
+        ok = (fclose(f) == 0) && ok;
+        if (!ok || rename(tmp.c_str(), cache_path.c_str()) != 0)
+            unlink(tmp.c_str());
+    }
+};
@@ -0,0 +1,247 @@
+#pragma once
+#include <gtk/gtk.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <stdint.h>
+#include <errno.h>
+#include <string>
+#include <vector>
+#include "Trace.h"
+#include "BinLog.h"
+
+// ----------------- MemoryBudget -----------------
+// One account of the memory held by every cache in the process (rendered
+// tiles, pre-rendered pages, decoded photos). Each cache registers as a
+// MemoryConsumer and reports the bytes it holds plus, for the entry it
+// would give up first, what rebuilding that entry costs. When the total
+// goes over the budget, or the kernel reports memory pressure, the entry
+// that is cheapest to rebuild per KiB is dropped, across all caches, until
+// the total fits again.
+//
+// Budget: $DWK_MEMORY_BUDGET_KB, default 12 MiB.
+// Pressure: a PSI trigger on /proc/pressure/memory where the kernel has
+// one (watched from the main loop, no polling); otherwise MemAvailable
+// (MemFree + Cached on kernels before 3.14) is read when a cache grows, at
+// most every few seconds.
+class MemoryConsumer
+{
+public:
+    virtual ~MemoryConsumer() {}
+    virtual const char *memory_name() const = 0;
+    virtual size_t memory_bytes() const = 0;
+    // Rebuild cost (microseconds per KiB) of the entry this cache would
+    // drop next; false if nothing can be dropped right now
+    virtual bool memory_cheapest(double *cost_per_kb) const = 0;
+    // Drop that entry; returns the bytes freed
+    virtual size_t memory_evict() = 0;
+};
+
+class MemoryBudget
+{
+public:
+    static constexpr size_t LOW_AVAILABLE = 8 * 1024 * 1024; // fallback pressure threshold
+    static constexpr int64_t MEMINFO_INTERVAL_US = 5 * 1000000;
+
+    size_t budget_bytes;
+
+    // Counters for reports
+    uint64_t pressure_events = 0;
+
+    struct Account
+    {
+        MemoryConsumer *consumer;
+        uint64_t evictions;
+        uint64_t evicted_bytes;
+    };
+
+    static MemoryBudget &get()
+    {
+        static MemoryBudget budget;
+        return budget;
+    }
+
+    void add(MemoryConsumer *c)
+    {
+        accounts.push_back(Account{c, 0, 0});
+    }
+
+    void remove(MemoryConsumer *c)
+    {
+        for (size_t i = 0; i < accounts.size(); i++)
+        {
+            if (accounts[i].consumer == c)
+            {
+                accounts.erase(accounts.begin() + i);
+                return;
+            }
+        }
+    }
+
+    // Called by a cache after it took more memory. The check runs from an
+    // idle, so nothing is dropped under a cache (or a widget's expose) that
+    // is still using it.
+    void grew()
+    {
+        if (!check_id)
+            check_id = g_idle_add(on_check_static, this);
+    }
+
+    // Enforce the budget and, without PSI, look at the system's free memory
+    // now and then
+    void check()
+    {
+        size_t total = total_bytes();
+        if (total > budget_bytes)
+        {
+            evict_to(budget_bytes);
+            return;
+        }
+        if (psi_fd >= 0)
+            return;
+        int64_t now = Trace::now_us();
+        if (now - last_meminfo_us < MEMINFO_INTERVAL_US)
+            return;
+        last_meminfo_us = now;
+        long long available = read_available();
+        if (available >= 0 && static_cast<size_t>(available) < LOW_AVAILABLE)
+            on_pressure();
+    }
+
+    size_t total_bytes() const
+    {
+        size_t total = 0;
+        for (const Account &a : accounts)
+            total += a.consumer->memory_bytes();
+        return total;
+    }
+
+    // Drop least valuable entries across all caches until `target` bytes
+    // remain or nothing more can be dropped
+    void evict_to(size_t target)
+    {
+        size_t total = total_bytes();
+        while (total > target)
+        {
+            Account *victim = nullptr;
+            double lowest = 0;
+            for (Account &a : accounts)
+            {
+                double cost;
+                if (a.consumer->memory_cheapest(&cost) && (!victim || cost < lowest))
+                {
+                    victim = &a;
+                    lowest = cost;
+                }
+            }
+            if (!victim)
+                break;
+            size_t freed = victim->consumer->memory_evict();
+            if (!freed)
+                break; // a cache that offered an entry but freed nothing
+            victim->evictions++;
+            victim->evicted_bytes += freed;
+            total = freed < total ? total - freed : 0;
+        }
+    }
+
+    // Under pressure the caches give back half of what they hold
+    void on_pressure()
+    {
+        pressure_events++;
+        size_t total = total_bytes();
+        BINLOG("[MEM] pressure, shrinking caches from %zu kb", total / 1024);
+        evict_to(total / 2);
+    }
+
+    const std::vector<Account> &all() const { return accounts; }
+    bool has_psi() const { return psi_fd >= 0; }
+
+    // Pixel memory of an image surface (0 for null)
+    static size_t surface_bytes(cairo_surface_t *s)
+    {
+        if (!s)
+            return 0;
+        return static_cast<size_t>(cairo_image_surface_get_stride(s)) * cairo_image_surface_get_height(s);
+    }
+
+private:
+    std::vector<Account> accounts;
+    int psi_fd = -1;
+    guint psi_watch = 0;
+    guint check_id = 0;
+    int64_t last_meminfo_us = 0;
+
+    MemoryBudget()
+    {
+        const char *env = g_getenv("DWK_MEMORY_BUDGET_KB");
+        long kb = env ? atol(env) : 0;
+        budget_bytes = kb > 0 ? static_cast<size_t>(kb) * 1024 : 12 * 1024 * 1024;
+        open_psi_trigger();
+    }
+
+    static gboolean on_check_static(gpointer data)
+    {
+        auto *self = static_cast<MemoryBudget *>(data);
+        self->check_id = 0;
+        self->check();
+        return FALSE;
+    }
+
+    // Wake when tasks stalled on memory for 150 ms within a 2 s window
+    void open_psi_trigger()
+    {
+        int fd = open("/proc/pressure/memory", O_RDWR | O_NONBLOCK | O_CLOEXEC);
+        if (fd < 0)
+            return; // no PSI on this kernel; MemAvailable fallback
+        const char trigger[] = "some 150000 2000000";
+        if (write(fd, trigger, sizeof(trigger)) < 0)
+        {
+            BINLOG("[MEM] psi trigger failed, errno %d", errno);
+            close(fd);
+            return;
+        }
+        psi_fd = fd;
+        GIOChannel *ch = g_io_channel_unix_new(psi_fd);
+        psi_watch = g_io_add_watch(ch, (GIOCondition)(G_IO_PRI | G_IO_ERR), on_psi_static, this);
+        g_io_channel_unref(ch);
+    }
+
+    static gboolean on_psi_static(GIOChannel *source, GIOCondition condition, gpointer data)
+    {
+        auto *self = static_cast<MemoryBudget *>(data);
+        if (condition & G_IO_ERR)
+        {
+            // Trigger gone (cgroup removed); fall back to MemAvailable
+            close(self->psi_fd);
+            self->psi_fd = -1;
+            self->psi_watch = 0;
+            return FALSE;
+        }
+        self->on_pressure();
+        return TRUE;
+    }
+
+    // Bytes the kernel could hand out without swapping, -1 if unknown
+    static long long read_available()
+    {
+        FILE *f = fopen("/proc/meminfo", "r");
+        if (!f)
+            return -1;
+        char line[128];
+        long long available = -1, free_kb = -1, cached = -1;
+        while (fgets(line, sizeof(line), f))
+        {
+            long long v;
+            if (sscanf(line, "MemAvailable: %lld", &v) == 1) available = v;
+            else if (sscanf(line, "MemFree: %lld", &v) == 1) free_kb = v;
+            else if (sscanf(line, "Cached: %lld", &v) == 1) cached = v;
+        }
+        fclose(f);
+        if (available < 0 && free_kb >= 0 && cached >= 0)
+            available = free_kb + cached;
+        return available < 0 ? -1 : available * 1024;
+    }
+};
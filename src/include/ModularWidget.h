@@ -3,6 +3,19 @@
 #include <vector>
 #include <algorithm>
 #include <cmath>
+#include <string.h>
+#include "Trace.h"
+#include "TextStyle.h"
+#include "WidgetStats.h"
+#include "Ghosting.h"
+#include "StateStore.h"
+#include "Clock.h"
+#include "ResumeMonitor.h"
+#include "WorkerPool.h"
+#include "TileCache.h"
+#include "RefreshScheduler.h"
+#include "TapAck.h"
+#include "UpdateLog.h"
 
 // ----------------- WidgetFactory -----------------
 class ModularWidget
@@ -13,14 +26,127 @@ public:
     int col, row;
     int width_blocks, height_blocks;
     int total_blocks_x, total_blocks_y; // total blocks in grid
+    int trace_id; // assigned when added to a KindleWindow
+    int page = 0; // dashboard page the widget lives on
+    WidgetStats stats;
+    GhostStats ghost; // kept up by the KindleWindow showing the widget
+    guint max_defer_ms = 60000; // longest wait of a background redraw
 
     ModularWidget(int col_, int row_,
                   int width_blocks_, int height_blocks_,
                   int total_blocks_x_ = 4, int total_blocks_y_ = 4)
         : col(col_), row(row_),
           width_blocks(width_blocks_), height_blocks(height_blocks_),
-          total_blocks_x(total_blocks_x_), total_blocks_y(total_blocks_y_)
+          total_blocks_x(total_blocks_x_), total_blocks_y(total_blocks_y_),
+          trace_id(0)
     {
+        instances().push_back(this);
+    }
+
+    virtual ~ModularWidget()
+    {
+        if (on_destroy())
+            on_destroy()(this);
+        WorkerPool::cancel_all(this);
+        RefreshScheduler::get().forget(this, gtkWidget);
+        auto &all = instances();
+        all.erase(std::remove(all.begin(), all.end(), this), all.end());
+    }
+
+    // Every live widget, in construction order (for process-wide reports)
+    static std::vector<ModularWidget *> &instances()
+    {
+        static std::vector<ModularWidget *> all;
+        return all;
+    }
+
+    // Optional process-wide hook run for every widget being destroyed
+    static void (*&on_destroy())(ModularWidget *)
+    {
+        static void (*hook)(ModularWidget *) = nullptr;
+        return hook;
+    }
+
+    // Name used in traces and reports
+    virtual const char *type_name() const { return "ModularWidget"; }
+
+    // Hash of everything that affects what the widget draws; equal hashes
+    // mean identical pixels. 0 means "unknown", never treated as equal.
+    virtual uint64_t state_hash() const { return 0; }
+
+    // Called once after the device wakes from suspend, before the single
+    // coalesced redraw. Time-driven widgets recompute from the current wall
+    // time and re-anchor their timers instead of replaying missed ticks.
+    virtual void on_resume() {}
+
+    // The display went dark (screensaver / screen off): stop every timer,
+    // animation and fetch. on_resume() runs when it is visible again.
+    virtual void on_display_off() {}
+
+    // Fields from a watched data file (DataSource.h): only the `count` pairs
+    // that changed. Apply the keys the widget knows, ignore the rest.
+    virtual void on_data(const char *const *keys, const char *const *values, int count) {}
+
+    // ---------------- Persistent state ----------------
+    // Process-wide store (set up in main); null disables persistence
+    static StateStore *&state_store()
+    {
+        static StateStore *store = nullptr;
+        return store;
+    }
+
+    // Serialize into `out` and return the bytes used (0 = nothing to keep).
+    // Bump state_version() whenever the layout changes.
+    virtual size_t save_state(uint8_t *out, size_t max) const { return 0; }
+    virtual void restore_state(const uint8_t *in, size_t len) {}
+    virtual uint16_t state_version() const { return 1; }
+
+    // Stable across restarts as long as the layout does not move the widget
+    // (page 0 keeps the single-page key)
+    uint32_t state_key() const
+    {
+        int pos[2] = {col, row};
+        uint64_t h = hash_bytes(type_name(), strlen(type_name()));
+        h = hash_bytes(pos, sizeof(pos), h);
+        if (page > 0)
+            h = hash_bytes(&page, sizeof(page), h);
+        return static_cast<uint32_t>(h);
+    }
+
+    // Widgets call this whenever persisted fields change. Ignored until the
+    // stored state was restored, so constructor defaults never overwrite it
+    // (returns false then).
+    bool persist_state() const
+    {
+        StateStore *store = state_store();
+        if (!store || !state_restored)
+            return false;
+        uint8_t buf[StateRecord::PAYLOAD_SIZE];
+        size_t len = save_state(buf, sizeof(buf));
+        if (len > 0)
+            store->put(state_key(), state_version(), buf, len);
+        return true;
+    }
+
+    // Called once the widget is fully constructed (KindleWindow does this)
+    void restore_persisted_state()
+    {
+        StateStore *store = state_store();
+        const uint8_t *data;
+        size_t len;
+        if (store && store->get(state_key(), state_version(), &data, &len))
+            restore_state(data, len);
+        state_restored = true;
+    }
+
+    // FNV-1a, chainable through `seed`
+    static uint64_t hash_bytes(const void *data, size_t len,
+                               uint64_t seed = 1469598103934665603ULL)
+    {
+        const unsigned char *p = static_cast<const unsigned char *>(data);
+        for (size_t i = 0; i < len; i++)
+            seed = (seed ^ p[i]) * 1099511628211ULL;
+        return seed;
     }
 
     void initialize()
@@ -32,6 +158,13 @@ public:
         // Track size allocation
         g_signal_connect(G_OBJECT(container), "size-allocate",
                          G_CALLBACK(on_size_allocate_static), this);
+
+        // Input and expose tracing/stats through the generic event signals,
+        // so subclass handlers need no changes
+        g_signal_connect(G_OBJECT(gtkWidget), "event",
+                         G_CALLBACK(on_event_static), this);
+        g_signal_connect(G_OBJECT(gtkWidget), "event-after",
+                         G_CALLBACK(on_event_after_static), this);
     }
     GtkWidget *get_widget() { return container; }
 
@@ -48,9 +181,83 @@ public:
     }
 
 protected:
+    // Request a redraw after a state change (traced as an update). The
+    // class tells RefreshScheduler how urgently it has to reach the panel;
+    // `part` limits the redraw to one child of gtkWidget.
+    void queue_redraw(RefreshClass cls = REFRESH_TIME_CRITICAL, GtkWidget *part = nullptr)
+    {
+        Trace::record(trace_id, TRACE_UPDATE);
+        RefreshScheduler::get().damage(this, part ? part : gtkWidget, cls, max_defer_ms);
+    }
+
+    // First thing in an input handler: put a tap mark on the panel at once
+    // (TapAck), traced as the input's first pixel. The redraw the tap causes
+    // follows through queue_redraw() and paints over the mark.
+    void acknowledge_tap(const GdkEventButton *event)
+    {
+        if (!GTK_WIDGET_DRAWABLE(gtkWidget))
+            return; // synthetic press before the widget is on screen
+        if (TapAck::show(gtkWidget, static_cast<int>(event->x_root), static_cast<int>(event->y_root)))
+            Trace::record(trace_id, TRACE_ACK);
+    }
+
+    // Paint width x height of content through the shared TileCache:
+    // draw(tile, width, height, data) runs only the first time this
+    // state_hash() is seen at this size
+    void paint_cached(cairo_t *cr, int width, int height, TileDrawFunc draw, gpointer data)
+    {
+        TileCache::get().paint(cr, type_name(), state_hash(), width, height, draw, data);
+    }
+
+    // Set a label's text, counted as a label update when it changed. GTK
+    // redraws a label as soon as its text changes, so the change is reported
+    // as a time-critical redraw of the label (held-back background redraws
+    // go out with it).
+    void set_label_text(GtkWidget *label, const char *text)
+    {
+        if (!TextStyle::set_text(label, text))
+            return;
+        stats.label_updates++;
+        queue_redraw(REFRESH_TIME_CRITICAL, label);
+    }
+
+    // Timer on the process Clock whose wakeups are counted against this
+    // widget (same return-value contract as g_timeout_add)
+    guint add_timer(guint interval_ms, GSourceFunc func, gpointer data)
+    {
+        auto *thunk = new TimerThunk{this, func, data};
+        return Clock::get()->add_timeout(interval_ms, on_timer_static, thunk, free_timer_static);
+    }
+
+    void remove_timer(guint id)
+    {
+        Clock::get()->remove(id);
+    }
+
+    // Run work(data) on the worker pool, then done(data) on the main
+    // thread; `destroy` frees `data` afterwards. `work` must not touch GTK
+    // or the widget (give `data` copies); a result still pending when the
+    // widget is destroyed is dropped.
+    void submit_work(WorkerFunc work, WorkerFunc done, gpointer data, GDestroyNotify destroy)
+    {
+        WorkerPool::get().submit(this, work, done, data, destroy);
+    }
+
+    // remove_timer for an id member that is 0 when no timer is running
+    void stop_timer(guint &id)
+    {
+        if (id > 0)
+        {
+            remove_timer(id);
+            id = 0;
+        }
+    }
+
     static void on_size_allocate_static(GtkWidget *widget, GtkAllocation *allocation, gpointer data)
     {
-        static_cast<ModularWidget *>(data)->on_size_allocate(allocation);
+        auto *self = static_cast<ModularWidget *>(data);
+        Trace::record(self->trace_id, TRACE_LAYOUT);
+        self->on_size_allocate(allocation);
     }
 
     virtual void on_size_allocate(GtkAllocation *allocation)
@@ -64,4 +271,62 @@ protected:
 
         gtk_widget_set_size_request(gtkWidget, w, h);
     }
+
+private:
+    int64_t expose_start_us = 0;
+    bool state_restored = false;
+
+    struct TimerThunk
+    {
+        ModularWidget *self;
+        GSourceFunc func;
+        gpointer data;
+    };
+
+    static gboolean on_timer_static(gpointer data)
+    {
+        auto *thunk = static_cast<TimerThunk *>(data);
+        thunk->self->stats.wakeups++;
+        // First wakeup after a suspend: every widget has just been brought up
+        // to date, so this stale tick is dropped (the timer itself is kept
+        // unless on_resume replaced it)
+        if (ResumeMonitor::poll())
+            return TRUE;
+        return thunk->func(thunk->data);
+    }
+
+    static void free_timer_static(gpointer data)
+    {
+        delete static_cast<TimerThunk *>(data);
+    }
+
+    static gboolean on_event_static(GtkWidget *widget, GdkEvent *event, gpointer data)
+    {
+        auto *self = static_cast<ModularWidget *>(data);
+        if (event->type == GDK_EXPOSE)
+        {
+            self->stats.expose_calls++;
+            self->stats.invalidated_bytes +=
+                static_cast<uint64_t>(event->expose.area.width) * event->expose.area.height;
+            self->expose_start_us = Trace::now_us();
+            Trace::record(self->trace_id, TRACE_EXPOSE_BEGIN);
+        }
+        else if (event->type == GDK_BUTTON_PRESS)
+        {
+            Trace::record(self->trace_id, TRACE_INPUT);
+            UpdateRecorder::get().input(self->state_key(), static_cast<int>(event->button.x),
+                                        static_cast<int>(event->button.y), event->button.button);
+        }
+        return FALSE;
+    }
+
+    static void on_event_after_static(GtkWidget *widget, GdkEvent *event, gpointer data)
+    {
+        auto *self = static_cast<ModularWidget *>(data);
+        if (event->type == GDK_EXPOSE)
+        {
+            self->stats.render_us += Trace::now_us() - self->expose_start_us;
+            Trace::record(self->trace_id, TRACE_EXPOSE_END);
+        }
+    }
 };
@@ -0,0 +1,159 @@
+#pragma once
+#include <gtk/gtk.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "DataDir.h"
+
+// ----------------- PhotoCache -----------------
+// Photos already scaled to a grid cell and dithered to the panel's 16 gray
+// levels, one file per (source, cell size) under <data dir>/photo-cache.
+// The key hashes the source path, size and mtime, so an edited photo gets a
+// new entry without reading the file to find out. A hit is one mmap and an
+// expand into a cairo surface; decoding happens only on a miss.
+//
+// File layout: PhotoTileHeader, then height rows of (width + 1) / 2 bytes,
+// high nibble first (0 = black, 15 = white).
+
+#pragma pack(push, 1)
+struct PhotoTileHeader
+{
+    uint32_t magic; // 'DWPT'
+    uint16_t width, height;
+};
+#pragma pack(pop)
+
+namespace PhotoCache
+{
+static constexpr uint32_t MAGIC = 0x54505744; // "DWPT"
+
+inline size_t stride(int width) { return (width + 1) / 2; }
+
+// Cache file for `source` drawn at width x height; empty if it is unreadable
+inline std::string tile_path(const std::string &source, int width, int height)
+{
+    struct stat st;
+    if (stat(source.c_str(), &st) < 0)
+        return std::string();
+
+    uint64_t h = 1469598103934665603ULL;
+    auto mix = [&h](const void *data, size_t len) {
+        const unsigned char *p = static_cast<const unsigned char *>(data);
+        for (size_t i = 0; i < len; i++)
+            h = (h ^ p[i]) * 1099511628211ULL;
+    };
+    int64_t id[2] = {static_cast<int64_t>(st.st_size), static_cast<int64_t>(st.st_mtime)};
+    mix(source.data(), source.size());
+    mix(id, sizeof(id));
+
+    static const std::string dir = [] {
+        std::string d = data_path("photo-cache");
+        g_mkdir_with_parents(d.c_str(), 0755);
+        return d;
+    }();
+    char name[64];
+    snprintf(name, sizeof(name), "/%016llx-%dx%d.tile", static_cast<unsigned long long>(h), width, height);
+    return dir + name;
+}
+
+// 4bpp gray rows to a cairo surface
+inline cairo_surface_t *expand(const uint8_t *px, int width, int height)
+{
+    cairo_surface_t *surface = cairo_image_surface_create(CAIRO_FORMAT_RGB24, width, height);
+    cairo_surface_flush(surface);
+    uint8_t *dst = cairo_image_surface_get_data(surface);
+    int dst_stride = cairo_image_surface_get_stride(surface);
+    for (int y = 0; y < height; y++)
+    {
+        const uint8_t *row = px + y * stride(width);
+        uint32_t *out = reinterpret_cast<uint32_t *>(dst + y * dst_stride);
+        for (int x = 0; x < width; x++)
+        {
+            uint32_t v = ((x & 1) ? (row[x / 2] & 0x0F) : (row[x / 2] >> 4)) * 17;
+            out[x] = v << 16 | v << 8 | v;
+        }
+    }
+    cairo_surface_mark_dirty(surface);
+    return surface;
+}
+
+// Gray surface from a cached tile, or null on a miss
+inline cairo_surface_t *load(const std::string &path)
+{
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        return nullptr;
+    struct stat st;
+    if (fstat(fd, &st) < 0 || st.st_size < (off_t)sizeof(PhotoTileHeader))
+    {
+        close(fd);
+        return nullptr;
+    }
+    void *map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED)
+        return nullptr;
+
+    const PhotoTileHeader *h = static_cast<const PhotoTileHeader *>(map);
+    cairo_surface_t *surface = nullptr;
+    if (h->magic == MAGIC && h->width > 0 && h->height > 0 &&
+        sizeof(PhotoTileHeader) + stride(h->width) * h->height <= (size_t)st.st_size)
+        surface = expand(reinterpret_cast<const uint8_t *>(h + 1), h->width, h->height);
+    munmap(map, st.st_size);
+    return surface;
+}
+
+// Floyd-Steinberg from 8-bit RGB(A) to 16 gray levels, packed 4bpp.
+// Pure computation: safe on a worker thread.
+inline std::string dither(const uint8_t *pixels, int width, int height, int rowstride, int channels)
+{
+    std::string out(stride(width) * height, '\0');
+    std::vector<int> err(width + 2, 0), next(width + 2, 0);
+    for (int y = 0; y < height; y++)
+    {
+        const uint8_t *row = pixels + y * rowstride;
+        std::fill(next.begin(), next.end(), 0);
+        for (int x = 0; x < width; x++)
+        {
+            const uint8_t *p = row + x * channels;
+            // Rec. 601 luma; carried error is kept in 1/16 units
+            int gray = (p[0] * 299 + p[1] * 587 + p[2] * 114) / 1000;
+            int v = std::max(0, std::min(255, gray + err[x + 1] / 16));
+            int level = (v + 8) / 17;
+            int e = v - level * 17;
+            err[x + 2] += e * 7;
+            next[x] += e * 3;
+            next[x + 1] += e * 5;
+            next[x + 2] += e * 1;
+            out[y * stride(width) + x / 2] |= (x & 1) ? level : level << 4;
+        }
+        err.swap(next);
+    }
+    return out;
+}
+
+// Write a tile (tmp + rename); worker-thread safe
+inline bool save(const std::string &path, int width, int height, const std::string &pixels)
+{
+    PhotoTileHeader h{MAGIC, static_cast<uint16_t>(width), static_cast<uint16_t>(height)};
+    std::string tmp = path + ".tmp";
+    FILE *f = fopen(tmp.c_str(), "wb");
+    if (!f)
+        return false;
+    bool ok = fwrite(&h, sizeof(h), 1, f) == 1 && fwrite(pixels.data(), pixels.size(), 1, f) == 1;
+    ok = (fclose(f) == 0) && ok;
+    if (!ok || rename(tmp.c_str(), path.c_str()) != 0)
+    {
+        unlink(tmp.c_str());
+        return false;
+    }
+    return true;
+}
+}
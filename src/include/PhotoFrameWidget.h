@@ -0,0 +1,362 @@
+#pragma once
+#include <gtk/gtk.h>
+#include <stdio.h>
+#include <string.h>
+#include <strings.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+#include "ModularWidget.h"
+#include "PhotoCache.h"
+#include "DataDir.h"
+#include "MemoryBudget.h"
+#include "BinLog.h"
+
+// Rotates through the photos (.jpg/.jpeg/.png) in a directory. Each photo
+// is shown from PhotoCache; on a miss it is decoded once, streamed into a
+// GdkPixbufLoader a chunk per idle with the output size set to the cell,
+// then dithered and written to the cache on the worker pool. The expanded
+// surface may be handed back to MemoryBudget; it is reloaded from its tile
+// at the next expose.
+class PhotoFrameWidget : public ModularWidget, public MemoryConsumer
+{
+public:
+    static constexpr size_t CHUNK = 32 * 1024; // bytes fed per idle
+
+    std::string dir;
+    int interval_s;
+
+    PhotoFrameWidget(int col_, int row_,
+                     int width_blocks_, int height_blocks_,
+                     const std::string &dir_ = data_path("photos"), int interval_s_ = 300,
+                     int total_blocks_x_ = 4, int total_blocks_y_ = 4)
+        : ModularWidget(col_, row_, width_blocks_, height_blocks_,
+                        total_blocks_x_, total_blocks_y_),
+          dir(dir_), interval_s(std::max(10, interval_s_))
+    {
+        gtkWidget = gtk_drawing_area_new();
+        g_signal_connect(G_OBJECT(gtkWidget), "expose-event",
+                         G_CALLBACK(on_expose_static), this);
+
+        scan();
+        timer_id = add_timer(interval_s * 1000, on_rotate_static, this);
+        MemoryBudget::get().add(this);
+
+        initialize();
+    }
+
+    ~PhotoFrameWidget()
+    {
+        MemoryBudget::get().remove(this);
+        if (timer_id > 0) remove_timer(timer_id);
+        cancel_decode();
+        if (surface)
+            cairo_surface_destroy(surface);
+    }
+
+    const char *type_name() const override { return "PhotoFrameWidget"; }
+
+    uint64_t state_hash() const override
+    {
+        return surface ? hash_bytes(shown_tile.data(), shown_tile.size()) : 0;
+    }
+
+    void on_resume() override
+    {
+        if (timer_id > 0) remove_timer(timer_id);
+        timer_id = add_timer(interval_s * 1000, on_rotate_static, this);
+        show_current();
+    }
+
+    void on_display_off() override
+    {
+        stop_timer(timer_id);
+        cancel_decode();
+    }
+
+    size_t save_state(uint8_t *out, size_t max) const override
+    {
+        uint32_t i = static_cast<uint32_t>(index);
+        memcpy(out, &i, sizeof(i));
+        return sizeof(i);
+    }
+
+    void restore_state(const uint8_t *in, size_t len) override
+    {
+        uint32_t i;
+        if (len != sizeof(i))
+            return;
+        memcpy(&i, in, sizeof(i));
+        index = photos.empty() ? 0 : i % photos.size();
+        show_current();
+    }
+
+    // MemoryConsumer: the shown photo, valued by what reloading its tile took
+    const char *memory_name() const override { return "photos"; }
+    size_t memory_bytes() const override { return MemoryBudget::surface_bytes(surface); }
+
+    bool memory_cheapest(double *cost_per_kb) const override
+    {
+        if (!surface || shown_tile.empty())
+            return false;
+        *cost_per_kb = static_cast<double>(reload_us) * 1024 / memory_bytes();
+        return true;
+    }
+
+    size_t memory_evict() override
+    {
+        size_t before = memory_bytes();
+        cairo_surface_destroy(surface);
+        surface = nullptr; // shown_tile stays for the reload
+        return before;
+    }
+
+    // Advance to the next photo
+    void rotate()
+    {
+        scan();
+        if (photos.empty())
+            return;
+        index = (index + 1) % photos.size();
+        persist_state();
+        show_current();
+    }
+
+private:
+    guint timer_id = 0;
+    std::vector<std::string> photos;
+    size_t index = 0;
+    int cell_w = 0, cell_h = 0;
+
+    cairo_surface_t *surface = nullptr;
+    std::string shown_tile;
+    int64_t reload_us = 0; // cost of getting `surface` back from its tile
+
+    // Streaming decode in progress
+    GdkPixbufLoader *loader = nullptr;
+    int decode_fd = -1;
+    guint decode_idle = 0;
+    std::string decode_tile;
+
+    void scan()
+    {
+        photos.clear();
+        DIR *d = opendir(dir.c_str());
+        if (!d)
+            return;
+        while (struct dirent *e = readdir(d))
+        {
+            const char *ext = strrchr(e->d_name, '.');
+            if (e->d_name[0] != '.' && ext &&
+                (strcasecmp(ext, ".jpg") == 0 || strcasecmp(ext, ".jpeg") == 0 || strcasecmp(ext, ".png") == 0))
+                photos.push_back(dir + "/" + e->d_name);
+        }
+        closedir(d);
+        std::sort(photos.begin(), photos.end());
+        if (index >= photos.size())
+            index = 0;
+    }
+
+    void show_current()
+    {
+        if (photos.empty() || cell_w <= 0 || cell_h <= 0)
+            return;
+        std::string tile = PhotoCache::tile_path(photos[index], cell_w, cell_h);
+        if (tile.empty() || tile == shown_tile || tile == decode_tile)
+            return;
+
+        int64_t start = Trace::now_us();
+        cairo_surface_t *cached = PhotoCache::load(tile);
+        if (cached)
+        {
+            reload_us = Trace::now_us() - start;
+            cancel_decode();
+            set_surface(cached, tile);
+        }
+        else
+            start_decode(photos[index], tile);
+    }
+
+    void set_surface(cairo_surface_t *s, const std::string &tile)
+    {
+        if (surface)
+            cairo_surface_destroy(surface);
+        surface = s;
+        shown_tile = tile;
+        queue_redraw(REFRESH_BACKGROUND);
+        MemoryBudget::get().grew();
+    }
+
+    // ---------------- Decode (main loop, one chunk per idle) ----------------
+    void start_decode(const std::string &source, const std::string &tile)
+    {
+        cancel_decode();
+        decode_fd = open(source.c_str(), O_RDONLY);
+        if (decode_fd < 0)
+            return;
+        loader = gdk_pixbuf_loader_new();
+        g_signal_connect(G_OBJECT(loader), "size-prepared", G_CALLBACK(on_size_prepared_static), this);
+        decode_tile = tile;
+        decode_idle = g_idle_add_full(G_PRIORITY_LOW, on_decode_idle_static, this, NULL);
+    }
+
+    void cancel_decode()
+    {
+        if (decode_idle > 0)
+            g_source_remove(decode_idle);
+        decode_idle = 0;
+        if (loader)
+        {
+            gdk_pixbuf_loader_close(loader, NULL);
+            g_object_unref(loader);
+            loader = nullptr;
+        }
+        if (decode_fd >= 0)
+            close(decode_fd);
+        decode_fd = -1;
+        decode_tile.clear();
+    }
+
+    // Scale on decode: fit the cell, keep the aspect ratio
+    static void on_size_prepared_static(GdkPixbufLoader *loader, int width, int height, gpointer data)
+    {
+        auto *self = static_cast<PhotoFrameWidget *>(data);
+        double scale = std::min(static_cast<double>(self->cell_w) / width,
+                                static_cast<double>(self->cell_h) / height);
+        if (scale < 1.0)
+            gdk_pixbuf_loader_set_size(loader, std::max(1, static_cast<int>(width * scale)),
+                                       std::max(1, static_cast<int>(height * scale)));
+    }
+
+    static gboolean on_decode_idle_static(gpointer data)
+    {
+        return static_cast<PhotoFrameWidget *>(data)->decode_step();
+    }
+
+    gboolean decode_step()
+    {
+        guchar buf[CHUNK];
+        ssize_t n = read(decode_fd, buf, sizeof(buf));
+        if (n > 0 && gdk_pixbuf_loader_write(loader, buf, n, NULL))
+            return TRUE;
+
+        decode_idle = 0;
+        bool ok = n == 0 && gdk_pixbuf_loader_close(loader, NULL);
+        GdkPixbuf *pixbuf = ok ? gdk_pixbuf_loader_get_pixbuf(loader) : nullptr;
+        if (!pixbuf)
+        {
+            BINLOG("[PHOTO] cannot decode %s", photos.empty() ? "" : photos[index].c_str());
+            g_object_unref(loader);
+            loader = nullptr;
+            close(decode_fd);
+            decode_fd = -1;
+            decode_tile.clear();
+            return FALSE;
+        }
+
+        // Copy the (cell-sized) pixels; dither and cache write on a worker
+        int w = gdk_pixbuf_get_width(pixbuf), h = gdk_pixbuf_get_height(pixbuf);
+        int rowstride = gdk_pixbuf_get_rowstride(pixbuf);
+        int channels = gdk_pixbuf_get_n_channels(pixbuf);
+        std::string pixels(reinterpret_cast<const char *>(gdk_pixbuf_get_pixels(pixbuf)),
+                           (h - 1) * rowstride + w * channels);
+        std::string tile = decode_tile;
+
+        g_object_unref(loader);
+        loader = nullptr;
+        close(decode_fd);
+        decode_fd = -1;
+
+        auto *job = new DitherJob{this, std::move(pixels), w, h, rowstride, channels, tile, std::string()};
+        submit_work(dither_static, dithered_static, job, free_job_static);
+        return FALSE;
+    }
+
+    // Worker side of a decode: owns its copy of the pixels
+    struct DitherJob
+    {
+        PhotoFrameWidget *self;
+        std::string pixels;
+        int w, h, rowstride, channels;
+        std::string tile;
+        std::string gray; // result
+    };
+
+    static void dither_static(gpointer data)
+    {
+        auto *job = static_cast<DitherJob *>(data);
+        job->gray = PhotoCache::dither(reinterpret_cast<const uint8_t *>(job->pixels.data()),
+                                       job->w, job->h, job->rowstride, job->channels);
+        PhotoCache::save(job->tile, job->w, job->h, job->gray);
+    }
+
+    static void dithered_static(gpointer data)
+    {
+        auto *job = static_cast<DitherJob *>(data);
+        PhotoFrameWidget *self = job->self;
+        if (job->tile != self->decode_tile)
+            return; // superseded meanwhile
+        self->decode_tile.clear();
+        int64_t start = Trace::now_us();
+        cairo_surface_t *s = PhotoCache::expand(reinterpret_cast<const uint8_t *>(job->gray.data()), job->w, job->h);
+        self->reload_us = Trace::now_us() - start; // about what a tile load costs
+        self->set_surface(s, job->tile);
+    }
+
+    static void free_job_static(gpointer data)
+    {
+        delete static_cast<DitherJob *>(data);
+    }
+
+    // ---------------- Drawing ----------------
+    static gboolean on_rotate_static(gpointer data)
+    {
+        static_cast<PhotoFrameWidget *>(data)->rotate();
+        return TRUE;
+    }
+
+    static gboolean on_expose_static(GtkWidget *widget, GdkEventExpose *event, gpointer data)
+    {
+        return static_cast<PhotoFrameWidget *>(data)->on_expose(widget, event);
+    }
+
+    gboolean on_expose(GtkWidget *widget, GdkEventExpose *event)
+    {
+        int w = widget->allocation.width;
+        int h = widget->allocation.height;
+        if (w != cell_w || h != cell_h)
+        {
+            cell_w = w;
+            cell_h = h;
+            show_current();
+        }
+        if (!surface && !shown_tile.empty())
+        {
+            // Given back to MemoryBudget; the tile brings it back
+            surface = PhotoCache::load(shown_tile);
+            if (surface)
+                MemoryBudget::get().grew();
+            else
+            {
+                shown_tile.clear(); // tile deleted meanwhile: decode again
+                show_current();
+            }
+        }
+
+        cairo_t *cr = gdk_cairo_create(widget->window);
+        cairo_set_source_rgb(cr, 1, 1, 1);
+        cairo_paint(cr);
+        if (surface)
+        {
+            int sw = cairo_image_surface_get_width(surface);
+            int sh = cairo_image_surface_get_height(surface);
+            cairo_set_source_surface(cr, surface, (w - sw) / 2, (h - sh) / 2);
+            cairo_paint(cr);
+        }
+        cairo_destroy(cr);
+        return FALSE;
+    }
+};
@@ -0,0 +1,217 @@
+#pragma once
+#include <gtk/gtk.h>
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+#include <errno.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <functional>
+#include <string>
+#include "BinLog.h"
+
+// ----------------- PowerState -----------------
+// Tells the dashboard when nobody can see it (screensaver up, screen off)
+// and when it is visible again. Events come from a pluggable PowerSource:
+//  - LipcPowerSource: powerd's event stream on the Kindle, via
+//      lipc-wait-event -m com.lab126.powerd <events>
+//  - SocketPowerSource: a local datagram socket for tests / desktop, e.g.
+//      echo off | socat - UNIX-SENDTO:/tmp/dynamic-widget-power.sock
+
+// Delivers raw event names (first word of each line / datagram)
+class PowerSource
+{
+public:
+    std::function<void(const std::string &)> on_event;
+
+    virtual ~PowerSource() {}
+    virtual bool ok() const = 0;
+
+protected:
+    void emit(const char *line)
+    {
+        std::string name(line, strcspn(line, " \t\r\n"));
+        if (!name.empty() && on_event)
+            on_event(name);
+    }
+};
+
+class LipcPowerSource : public PowerSource
+{
+public:
+    LipcPowerSource() : pid(0), watch_id(0)
+    {
+        gchar *argv[] = {(gchar *)"lipc-wait-event", (gchar *)"-m", (gchar *)"com.lab126.powerd",
+                         (gchar *)"goingToScreenSaver,outOfScreenSaver,suspending,resuming", NULL};
+        gint out_fd;
+        if (!g_spawn_async_with_pipes(NULL, argv, NULL, G_SPAWN_SEARCH_PATH, NULL, NULL,
+                                      &pid, NULL, &out_fd, NULL, NULL))
+        {
+            pid = 0;
+            return;
+        }
+
+        GIOChannel *ch = g_io_channel_unix_new(out_fd);
+        g_io_channel_set_close_on_unref(ch, TRUE);
+        watch_id = g_io_add_watch(ch, (GIOCondition)(G_IO_IN | G_IO_HUP), on_line_static, this);
+        g_io_channel_unref(ch);
+    }
+
+    ~LipcPowerSource()
+    {
+        if (watch_id > 0) g_source_remove(watch_id);
+        if (pid > 0)
+        {
+            kill(pid, SIGTERM);
+            g_spawn_close_pid(pid);
+        }
+    }
+
+    bool ok() const override { return pid > 0; }
+
+private:
+    GPid pid;
+    guint watch_id;
+
+    static gboolean on_line_static(GIOChannel *source, GIOCondition condition, gpointer data)
+    {
+        auto *self = static_cast<LipcPowerSource *>(data);
+        gchar *line = NULL;
+        if (g_io_channel_read_line(source, &line, NULL, NULL, NULL) != G_IO_STATUS_NORMAL)
+        {
+            g_free(line);
+            BINLOG("[POWER] lipc-wait-event exited");
+            self->watch_id = 0;
+            return FALSE;
+        }
+        self->emit(line);
+        g_free(line);
+        return TRUE;
+    }
+};
+
+class SocketPowerSource : public PowerSource
+{
+public:
+    SocketPowerSource(const char *socket_path_ = "/tmp/dynamic-widget-power.sock")
+        : socket_path(socket_path_), fd(-1), watch_id(0)
+    {
+        fd = socket(AF_UNIX, SOCK_DGRAM, 0);
+        if (fd < 0)
+        {
+            BINLOG("[POWER] socket failed, errno %d", errno);
+            return;
+        }
+
+        struct sockaddr_un addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sun_family = AF_UNIX;
+        strncpy(addr.sun_path, socket_path.c_str(), sizeof(addr.sun_path) - 1);
+        unlink(socket_path.c_str());
+
+        if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0)
+        {
+            BINLOG("[POWER] bind failed, errno %d", errno);
+            close(fd);
+            fd = -1;
+            return;
+        }
+
+        fcntl(fd, F_SETFL, O_NONBLOCK);
+        GIOChannel *ch = g_io_channel_unix_new(fd);
+        watch_id = g_io_add_watch(ch, G_IO_IN, on_datagram_static, this);
+        g_io_channel_unref(ch);
+    }
+
+    ~SocketPowerSource()
+    {
+        if (watch_id > 0) g_source_remove(watch_id);
+        if (fd >= 0)
+        {
+            close(fd);
+            unlink(socket_path.c_str());
+        }
+    }
+
+    bool ok() const override { return fd >= 0; }
+
+private:
+    std::string socket_path;
+    int fd;
+    guint watch_id;
+
+    static gboolean on_datagram_static(GIOChannel *source, GIOCondition condition, gpointer data)
+    {
+        auto *self = static_cast<SocketPowerSource *>(data);
+        char buf[128];
+        ssize_t n;
+        while ((n = recv(self->fd, buf, sizeof(buf) - 1, 0)) > 0)
+        {
+            buf[n] = '\0';
+            self->emit(buf);
+        }
+        return TRUE;
+    }
+};
+
+class PowerState
+{
+public:
+    bool display_active;
+
+    // on_inactive / on_active run once per transition
+    PowerState(PowerSource *source_, std::function<void()> on_inactive_,
+               std::function<void()> on_active_)
+        : display_active(true), source(source_),
+          on_inactive(on_inactive_), on_active(on_active_)
+    {
+        source->on_event = [this](const std::string &name) { handle(name); };
+    }
+
+    ~PowerState()
+    {
+        delete source;
+    }
+
+    PowerState(const PowerState &) = delete;
+    PowerState &operator=(const PowerState &) = delete;
+
+    // Production source when powerd is reachable, the socket otherwise
+    static PowerSource *default_source()
+    {
+        PowerSource *lipc = new LipcPowerSource();
+        if (lipc->ok())
+            return lipc;
+        delete lipc;
+        return new SocketPowerSource();
+    }
+
+    void handle(const std::string &name)
+    {
+        // A resume from suspend still shows the screensaver, so only
+        // outOfScreenSaver (or a test "on") makes the display visible again
+        if (name == "goingToScreenSaver" || name == "suspending" || name == "off")
+            set_active(false);
+        else if (name == "outOfScreenSaver" || name == "on")
+            set_active(true);
+    }
+
+private:
+    PowerSource *source;
+    std::function<void()> on_inactive;
+    std::function<void()> on_active;
+
+    void set_active(bool active)
+    {
+        if (active == display_active)
+            return;
+        display_active = active;
+        BINLOG("[POWER] display %s", active ? "active" : "inactive");
+        if (active)
+            on_active();
+        else
+            on_inactive();
+    }
+};
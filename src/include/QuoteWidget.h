@@ -1,6 +1,8 @@
 #pragma once
 #include "ModularWidget.h"
+#include "TextStyle.h"
 #include <string>
+#include <string.h>
 
 class QuoteWidget : public ModularWidget
 {
@@ -28,6 +30,7 @@ public:
         gtk_label_set_line_wrap_mode(GTK_LABEL(quote_label), PANGO_WRAP_WORD_CHAR);
 #endif
         gtk_label_set_justify(GTK_LABEL(quote_label), GTK_JUSTIFY_CENTER);
+        quote_style().apply(quote_label);
 
         gtk_misc_set_padding(GTK_MISC(quote_label), 6, 6); // left/right & top/bottom
         // Wrap label in alignment to allow vertical expansion
@@ -38,7 +41,7 @@ public:
         gtk_container_add(GTK_CONTAINER(gtkWidget), align);
 
         // Apply initial text
-        set_markup(text);
+        set_label_text(quote_label, text.c_str());
 
         gtk_widget_show_all(gtkWidget);
 
@@ -47,10 +50,42 @@ public:
 
     GtkWidget *get_widget() { return gtkWidget; }
 
+    const char *type_name() const override { return "QuoteWidget"; }
+
+    uint64_t state_hash() const override
+    {
+        return hash_bytes(text.data(), text.size());
+    }
+
+    // Quotes longer than a state record are simply not persisted
+    size_t save_state(uint8_t *out, size_t max) const override
+    {
+        if (text.size() > max)
+            return 0;
+        memcpy(out, text.data(), text.size());
+        return text.size();
+    }
+
+    void restore_state(const uint8_t *in, size_t len) override
+    {
+        update(std::string(reinterpret_cast<const char *>(in), len));
+    }
+
+    // Data file field: text
+    void on_data(const char *const *keys, const char *const *values, int count) override
+    {
+        for (int i = 0; i < count; i++)
+        {
+            if (strcmp(keys[i], "text") == 0)
+                update(values[i]);
+        }
+    }
+
     void update(const std::string &quote)
     {
         text = quote;
-        set_markup(text);
+        set_label_text(quote_label, text.c_str());
+        persist_state();
     }
 
 protected:
@@ -74,10 +109,9 @@ protected:
     }
 
 private:
-    void set_markup(const std::string &quote)
+    static const TextStyle &quote_style()
     {
-        std::string markup =
-            "<span size='11000' style='italic'>" + quote + "</span>";
-        gtk_label_set_markup(GTK_LABEL(quote_label), markup.c_str());
+        static const TextStyle style(11000, PANGO_WEIGHT_NORMAL, PANGO_STYLE_ITALIC);
+        return style;
     }
 };
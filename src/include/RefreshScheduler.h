@@ -0,0 +1,171 @@
+#pragma once
+#include <gtk/gtk.h>
+#include <stdint.h>
+#include <algorithm>
+#include <vector>
+#include "Clock.h"
+#include "EinkPanel.h"
+
+// ----------------- RefreshScheduler -----------------
+// Every redraw a ModularWidget asks for carries a class:
+//  - interactive: the user is waiting (a tap's animation). Drawn at once,
+//    then sent to the controller as a fast DU update of just that region,
+//    ahead of anything else.
+//  - time-critical: the content is wrong until shown (clock, progress).
+//    Drawn at once through the normal path.
+//  - background: nobody waits for it (battery level, a new photo). Held
+//    back and drawn together with the next time-critical redraw, so both
+//    reach the panel as one update; a per-widget deadline bounds the wait.
+enum RefreshClass
+{
+    REFRESH_INTERACTIVE,
+    REFRESH_TIME_CRITICAL,
+    REFRESH_BACKGROUND,
+    REFRESH_CLASSES
+};
+
+class RefreshScheduler
+{
+public:
+    // Counters for reports
+    uint64_t requests[REFRESH_CLASSES] = {};
+    uint64_t merged = 0;       // background redraws drawn with a time-critical one
+    uint64_t forced = 0;       // background redraws drawn at their deadline
+    uint64_t fast_updates = 0; // DU updates sent for interactive regions
+
+    static RefreshScheduler &get()
+    {
+        static RefreshScheduler scheduler;
+        return scheduler;
+    }
+
+    // `owner` identifies the requester for forget(); `max_defer_ms` bounds
+    // how long a background redraw may wait
+    void damage(const void *owner, GtkWidget *widget, RefreshClass cls, guint max_defer_ms)
+    {
+        requests[cls]++;
+        if (cls == REFRESH_BACKGROUND && max_defer_ms > 0)
+        {
+            defer(owner, widget, max_defer_ms);
+            return;
+        }
+
+        gtk_widget_queue_draw(widget);
+        if (cls == REFRESH_INTERACTIVE)
+        {
+            if (std::find(fast.begin(), fast.end(), widget) == fast.end())
+                fast.push_back(widget);
+            // Right after GDK has drawn the frame
+            if (!fast_idle)
+                fast_idle = g_idle_add_full(GDK_PRIORITY_REDRAW + 1, on_fast_idle_static, this, NULL);
+        }
+        else if (!deferred.empty())
+        {
+            merged += deferred.size();
+            flush();
+        }
+    }
+
+    // Draw every held-back redraw now (e.g. for a catch-up render)
+    void flush()
+    {
+        for (const Deferred &d : deferred)
+            gtk_widget_queue_draw(d.widget);
+        deferred.clear();
+        stop_timer();
+    }
+
+    // Drop whatever `owner` (drawing into `widget`) has pending; called when
+    // it is destroyed
+    void forget(const void *owner, GtkWidget *widget)
+    {
+        fast.erase(std::remove(fast.begin(), fast.end(), widget), fast.end());
+        deferred.erase(std::remove_if(deferred.begin(), deferred.end(),
+                                      [owner](const Deferred &d) { return d.owner == owner; }),
+                       deferred.end());
+        if (deferred.empty())
+            stop_timer();
+    }
+
+    size_t pending() const { return deferred.size(); }
+
+private:
+    struct Deferred
+    {
+        const void *owner;
+        GtkWidget *widget;
+        int64_t deadline_us;
+    };
+    std::vector<Deferred> deferred;
+    std::vector<GtkWidget *> fast;
+    guint fast_idle = 0;
+    guint timer_id = 0;
+    int64_t timer_deadline_us = 0;
+
+    RefreshScheduler() {}
+
+    void defer(const void *owner, GtkWidget *widget, guint max_defer_ms)
+    {
+        int64_t deadline = Clock::get()->monotonic_us() + static_cast<int64_t>(max_defer_ms) * 1000;
+        auto it = std::find_if(deferred.begin(), deferred.end(),
+                               [owner](const Deferred &d) { return d.owner == owner; });
+        if (it != deferred.end())
+            return; // already waiting; a newer state does not extend the deadline
+        deferred.push_back(Deferred{owner, widget, deadline});
+
+        // One timer, aimed at the earliest deadline
+        if (timer_id && timer_deadline_us <= deadline)
+            return;
+        stop_timer();
+        timer_deadline_us = deadline;
+        timer_id = Clock::get()->add_timeout(max_defer_ms, on_deadline_static, this);
+    }
+
+    void stop_timer()
+    {
+        if (timer_id)
+            Clock::get()->remove(timer_id);
+        timer_id = 0;
+    }
+
+    // The earliest deadline is due: everything waiting goes in the same batch
+    static gboolean on_deadline_static(gpointer data)
+    {
+        auto *self = static_cast<RefreshScheduler *>(data);
+        self->timer_id = 0;
+        self->forced += self->deferred.size();
+        self->flush();
+        return FALSE;
+    }
+
+    static gboolean on_fast_idle_static(gpointer data)
+    {
+        auto *self = static_cast<RefreshScheduler *>(data);
+        self->fast_idle = 0;
+        self->send_fast_updates();
+        return FALSE;
+    }
+
+    void send_fast_updates()
+    {
+        EinkPanel &panel = EinkPanel::get();
+        if (panel.is_open())
+            gdk_flush(); // the X server has the pixels in the framebuffer
+        for (GtkWidget *widget : fast)
+        {
+            if (!widget->window || !GTK_WIDGET_DRAWABLE(widget))
+                continue;
+            int ox, oy;
+            gdk_window_get_origin(widget->window, &ox, &oy);
+            GtkAllocation &a = widget->allocation;
+            if (GTK_WIDGET_NO_WINDOW(widget))
+            {
+                ox += a.x;
+                oy += a.y;
+            }
+            if (panel.send_update(ox, oy, a.width, a.height, EinkPanel::WAVEFORM_DU, false))
+                fast_updates++;
+        }
+        fast.clear();
+    }
+};
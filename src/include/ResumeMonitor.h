@@ -0,0 +1,155 @@
+#pragma once
+#include <gtk/gtk.h>
+#include <stdint.h>
+#include <time.h>
+#include <unistd.h>
+#include <functional>
+#include <sys/timerfd.h>
+
+#ifndef CLOCK_BOOTTIME
+#define CLOCK_BOOTTIME 7
+#endif
+
+// ----------------- ResumeMonitor -----------------
+// Detects that the device was suspended: CLOCK_MONOTONIC (which GLib timers
+// use) stops during suspend, CLOCK_BOOTTIME keeps counting, so their offset
+// jumps by the time spent asleep. The offset is compared
+//  - on every widget timer wakeup (poll(), two clock reads),
+//  - when a CLOCK_BOOTTIME timerfd expires, which happens right after resume
+//    whenever the sleep outlasted the remaining period,
+//  - or immediately when a power-manager event calls notify_resume().
+// The handler (KindleWindow) then brings every widget up to date in one pass.
+class ResumeMonitor
+{
+public:
+    static constexpr int64_t THRESHOLD_US = 2000000; // ignore scheduling jitter
+
+    ResumeMonitor(std::function<void()> handler_, int check_period_s_ = 60)
+        : handler(handler_), check_period_s(check_period_s_), timer_fd(-1), watch_id(0),
+          in_handler(false), enabled(true)
+    {
+        last_offset = boottime_offset_us();
+        active() = this;
+
+        timer_fd = timerfd_create(CLOCK_BOOTTIME, TFD_NONBLOCK | TFD_CLOEXEC);
+        if (timer_fd >= 0)
+        {
+            arm(check_period_s);
+
+            GIOChannel *ch = g_io_channel_unix_new(timer_fd);
+            watch_id = g_io_add_watch(ch, G_IO_IN, on_timerfd_static, this);
+            g_io_channel_unref(ch);
+        }
+    }
+
+    ~ResumeMonitor()
+    {
+        if (watch_id > 0) g_source_remove(watch_id);
+        if (timer_fd >= 0) close(timer_fd);
+        if (active() == this)
+            active() = nullptr;
+    }
+
+    ResumeMonitor(const ResumeMonitor &) = delete;
+    ResumeMonitor &operator=(const ResumeMonitor &) = delete;
+
+    // Cheap check from hot paths; true if a resume was handled
+    static bool poll()
+    {
+        ResumeMonitor *m = active();
+        return m && m->enabled && m->check();
+    }
+
+    bool check()
+    {
+        int64_t offset = boottime_offset_us();
+        if (offset - last_offset < THRESHOLD_US)
+            return false;
+        last_offset = offset;
+        fire();
+        return true;
+    }
+
+    // External resume signal (e.g. powerd "outOfSuspend")
+    void notify_resume()
+    {
+        rebase();
+        fire();
+    }
+
+    // Accept the current offset without firing (someone else caught up)
+    void rebase()
+    {
+        last_offset = boottime_offset_us();
+    }
+
+    // While the display is off nothing needs catching up; stop the timerfd
+    // so it does not wake the process either
+    void set_enabled(bool enable)
+    {
+        if (enable == enabled)
+            return;
+        enabled = enable;
+        if (timer_fd >= 0)
+            arm(enable ? check_period_s : 0);
+        if (enable)
+            rebase();
+    }
+
+    static ResumeMonitor *&active()
+    {
+        static ResumeMonitor *monitor = nullptr;
+        return monitor;
+    }
+
+private:
+    std::function<void()> handler;
+    int check_period_s;
+    int64_t last_offset;
+    int timer_fd;
+    guint watch_id;
+    bool in_handler;
+    bool enabled;
+
+    // Periodic expiry every period_s; 0 disarms
+    void arm(int period_s)
+    {
+        struct itimerspec spec = {};
+        spec.it_value.tv_sec = period_s;
+        spec.it_interval.tv_sec = period_s;
+        timerfd_settime(timer_fd, 0, &spec, NULL);
+    }
+
+    static int64_t read_us(clockid_t id)
+    {
+        struct timespec ts;
+        clock_gettime(id, &ts);
+        return static_cast<int64_t>(ts.tv_sec) * 1000000 + ts.tv_nsec / 1000;
+    }
+
+    // Time spent suspended since boot
+    static int64_t boottime_offset_us()
+    {
+        return read_us(CLOCK_BOOTTIME) - read_us(CLOCK_MONOTONIC);
+    }
+
+    void fire()
+    {
+        if (in_handler)
+            return; // timers restarted by the handler may poll again
+        in_handler = true;
+        handler();
+        in_handler = false;
+    }
+
+    static gboolean on_timerfd_static(GIOChannel *source, GIOCondition condition, gpointer data)
+    {
+        auto *self = static_cast<ResumeMonitor *>(data);
+        uint64_t expirations;
+        ssize_t n = read(self->timer_fd, &expirations, sizeof(expirations));
+        (void)n;
+        if (self->enabled)
+            self->check();
+        return TRUE;
+    }
+};
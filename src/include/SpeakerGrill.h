@@ -29,17 +29,18 @@ public:
 
     GtkWidget *get_widget() { return gtkWidget; }
 
-protected:
-    static gboolean on_expose_static(GtkWidget *widget, GdkEventExpose *event, gpointer data)
+    const char *type_name() const override { return "SpeakerGrill"; }
+
+    uint64_t state_hash() const override
     {
-        return static_cast<SpeakerGrill *>(data)->on_expose(widget, event);
+        int state[2] = {radius, filled_dots};
+        return hash_bytes(state, sizeof(state));
     }
 
-    virtual gboolean on_expose(GtkWidget *widget, GdkEventExpose *event)
+protected:
+    // rows, cols and total_dots for a drawing area of width x height
+    void layout_grid(int width, int height)
     {
-        int width = widget->allocation.width;
-        int height = widget->allocation.height;
-
         double r = static_cast<double>(radius);
         double s = 4.0 * r;
 
@@ -50,15 +51,43 @@ protected:
         if (rows < 1) rows = 1;
 
         total_dots = rows * cols;
+    }
+
+    static gboolean on_expose_static(GtkWidget *widget, GdkEventExpose *event, gpointer data)
+    {
+        return static_cast<SpeakerGrill *>(data)->on_expose(widget, event);
+    }
+
+    virtual gboolean on_expose(GtkWidget *widget, GdkEventExpose *event)
+    {
+        int width = widget->allocation.width;
+        int height = widget->allocation.height;
+
+        layout_grid(width, height);
 
         if (filled_dots < 0 || filled_dots > total_dots)
             filled_dots = total_dots;
 
+        cairo_t *cr = gdk_cairo_create(widget->window);
+        paint_cached(cr, width, height, draw_static, this);
+        cairo_destroy(cr);
+        return FALSE;
+    }
+
+    static void draw_static(cairo_t *cr, int width, int height, gpointer data)
+    {
+        static_cast<SpeakerGrill *>(data)->draw(cr, width, height);
+    }
+
+    // Content for the current state; painted through the TileCache
+    virtual void draw(cairo_t *cr, int width, int height)
+    {
+        double r = static_cast<double>(radius);
+        double s = 4.0 * r;
+
         double offset_x = (width - (cols - 1) * s - 2 * r) / 2.0 + r;
         double offset_y = (height - (rows - 1) * s - 2 * r) / 2.0 + r;
 
-        cairo_t *cr = gdk_cairo_create(widget->window);
-
         int count = 0;
         for (int i = 0; i < rows; i++)
         {
@@ -78,8 +107,5 @@ protected:
                 count++;
             }
         }
-
-        cairo_destroy(cr);
-        return FALSE;
     }
 };
@@ -1,85 +1,235 @@
 #pragma once
+#include <string.h>
+#include <time.h>
+#include <string>
 #include "SpeakerGrill.h"
+#include "BinLog.h"
 
+// Progress of a period as filled dots. Clock periods (minute, hour, day)
+// follow local wall time; relative ones (pomodoro, or any `seconds`) run
+// from when they were started and restart when done, or on a tap.
+//
+// No tick: the instant of the next dot transition is computed from the
+// period and the grid size, and one one-shot timer is set for exactly then,
+// so the widget wakes once per visible change. The n dots of a grid give
+// n + 1 equally long states (empty .. full).
 class SpeakerGrillCounter : public SpeakerGrill
 {
-    unsigned int timer_id;
-    int elapsed_seconds;
-    int total_seconds = 60;
-    bool resetTimerAfterDone = true;
-    bool syncWithClock = true;
-    int prev_filled_dots = 0;
-
 public:
+    enum Period
+    {
+        PERIOD_MINUTE,
+        PERIOD_HOUR,
+        PERIOD_DAY,
+        PERIOD_RELATIVE, // `relative_ms` from `anchor_ms`, repeating
+    };
+
+    // "minute", "hour", "day", "pomodoro" (25 min) or "<n>s"/"<n>m"/"<n>h"
+    static bool parse_period(const std::string &s, Period *period, int64_t *relative_ms)
+    {
+        if (s == "minute") *period = PERIOD_MINUTE;
+        else if (s == "hour") *period = PERIOD_HOUR;
+        else if (s == "day") *period = PERIOD_DAY;
+        else if (s == "pomodoro")
+        {
+            *period = PERIOD_RELATIVE;
+            *relative_ms = 25 * 60 * 1000;
+        }
+        else
+        {
+            char *end;
+            long n = strtol(s.c_str(), &end, 10);
+            int64_t unit = *end == 's' ? 1000 : *end == 'm' ? 60000 : *end == 'h' ? 3600000 : 0;
+            if (n <= 0 || !unit || end[1])
+                return false;
+            *period = PERIOD_RELATIVE;
+            *relative_ms = n * unit;
+        }
+        return true;
+    }
+
     SpeakerGrillCounter(int col_, int row_,
                         int width_blocks_, int height_blocks_,
-                        int radius_,
+                        int radius_, const std::string &period_name = "minute",
                         int total_blocks_x_ = 4, int total_blocks_y_ = 4)
         : SpeakerGrill(col_, row_, width_blocks_, height_blocks_, radius_,
                        total_blocks_x_, total_blocks_y_),
-          timer_id(0), elapsed_seconds(0)
+          timer_id(0), anchor_saved(false)
     {
-        // Start timer: 1 second interval
-        timer_id = g_timeout_add(1000, on_tick_static, this);
+        if (!parse_period(period_name, &period, &relative_ms))
+        {
+            BINLOG("[GRILL] unknown period '%s', using minute", period_name.c_str());
+            period = PERIOD_MINUTE;
+        }
+        anchor_ms = Clock::get()->wall_time_ms();
+        filled_dots = 0;
+
+        if (period == PERIOD_RELATIVE)
+        {
+            gtk_widget_set_events(gtkWidget, GDK_BUTTON_PRESS_MASK);
+            g_signal_connect(G_OBJECT(gtkWidget), "button-press-event",
+                             G_CALLBACK(on_click_static), this);
+        }
     }
 
     ~SpeakerGrillCounter()
     {
         if (timer_id > 0)
-            g_source_remove(timer_id);
+            remove_timer(timer_id);
     }
 
-private:
-    static gboolean on_tick_static(gpointer data)
+    const char *type_name() const override { return "SpeakerGrillCounter"; }
+
+    // Only relative periods have a start worth keeping; clock ones derive it
+    size_t save_state(uint8_t *out, size_t max) const override
+    {
+        if (period != PERIOD_RELATIVE)
+            return 0;
+        int64_t state[2] = {anchor_ms, relative_ms};
+        memcpy(out, state, sizeof(state));
+        return sizeof(state);
+    }
+
+    void restore_state(const uint8_t *in, size_t len) override
+    {
+        int64_t state[2];
+        if (period != PERIOD_RELATIVE || len != sizeof(state))
+            return;
+        memcpy(state, in, sizeof(state));
+        if (state[1] != relative_ms || state[0] > Clock::get()->wall_time_ms())
+            return; // other period, or a clock that went backwards
+        anchor_ms = state[0];
+        update();
+    }
+
+    uint16_t state_version() const override { return 2; }
+
+    // Start a relative period over
+    void restart()
+    {
+        if (period != PERIOD_RELATIVE)
+            return;
+        anchor_ms = Clock::get()->wall_time_ms();
+        persist_state();
+        update();
+    }
+
+    // Everything is derived from wall time: just recompute and re-aim
+    void on_resume() override
     {
-        return static_cast<SpeakerGrillCounter *>(data)->on_tick();
+        update();
     }
 
-    gboolean on_tick()
+    void on_display_off() override
     {
-        int seconds = 0;
+        stop_timer(timer_id);
+    }
+
+protected:
+    gboolean on_expose(GtkWidget *widget, GdkEventExpose *event) override
+    {
+        int before = total_dots;
+        layout_grid(widget->allocation.width, widget->allocation.height);
+        if (total_dots != before)
+            update(false); // this expose already paints the new state
+        return SpeakerGrill::on_expose(widget, event);
+    }
+
+private:
+    guint timer_id;
+    Period period = PERIOD_MINUTE;
+    int64_t relative_ms = 60000;
+    int64_t anchor_ms; // start of the relative period
+    bool anchor_saved; // anchor_ms reached the StateStore
 
-        if (syncWithClock)
+    // Current period as [start, start + length) in wall ms
+    void current_period(int64_t now, int64_t *start, int64_t *length)
+    {
+        if (period == PERIOD_RELATIVE)
         {
-            // ✅ Sync with wall clock
-            time_t now = time(NULL);
-            struct tm *lt = localtime(&now);
-            seconds = lt->tm_sec + 1; // 0–59
+            // Whole periods that passed (e.g. while off) are skipped; a
+            // fresh anchor is saved once the store takes it, so a restart
+            // mid-period resumes instead of starting over
+            int64_t done = (now - anchor_ms) / relative_ms;
+            if (done > 0)
+                anchor_ms += done * relative_ms;
+            if (done > 0 || !anchor_saved)
+                anchor_saved = persist_state();
+            *start = anchor_ms;
+            *length = relative_ms;
+            return;
         }
-        else
+
+        time_t secs = static_cast<time_t>(now / 1000);
+        struct tm t;
+        localtime_r(&secs, &t);
+        int64_t ms = now % 1000;
+        if (period == PERIOD_MINUTE)
         {
-            // ✅ Relative mode
-            elapsed_seconds++;
-            if (elapsed_seconds > total_seconds)
-                elapsed_seconds = total_seconds; // clamp at 60
-            seconds = elapsed_seconds;
+            *start = now - t.tm_sec * 1000 - ms;
+            *length = 60000;
         }
-
-        if (total_dots > 0)
+        else if (period == PERIOD_HOUR)
         {
-            double dots_per_second = static_cast<double>(total_dots) / 60.0;
-            filled_dots = static_cast<int>(floor(seconds * dots_per_second));
-
-            // Clamp in case rounding overshoots
-            if (filled_dots > total_dots)
-                filled_dots = total_dots;
-            if(filled_dots > prev_filled_dots)
-            {
-                gtk_widget_queue_draw(gtkWidget);
-            }
-            prev_filled_dots = filled_dots;
+            *start = now - (t.tm_min * 60 + t.tm_sec) * 1000 - ms;
+            *length = 3600000;
         }
-
-        // reset timer after total_seconds
-        if (!syncWithClock && seconds == total_seconds)
+        else
         {
-            seconds = 0;
-            gtk_widget_queue_draw(gtkWidget);
+            // Local midnight to midnight: 23 or 25 h across DST changes
+            t.tm_hour = t.tm_min = t.tm_sec = 0;
+            t.tm_isdst = -1;
+            time_t midnight = mktime(&t);
+            t.tm_mday += 1;
+            t.tm_isdst = -1;
+            time_t next = mktime(&t);
+            *start = static_cast<int64_t>(midnight) * 1000;
+            *length = static_cast<int64_t>(next - midnight) * 1000;
         }
-        else if(!resetTimerAfterDone)
+    }
+
+    // Recompute the dots for now and arm the timer for the next change
+    void update(bool redraw = true)
+    {
+        stop_timer(timer_id);
+        if (total_dots <= 0)
+            return; // grid unknown until the first expose
+
+        int64_t now = Clock::get()->wall_time_ms();
+        int64_t start, length;
+        current_period(now, &start, &length);
+
+        // State k (0..n) covers [k, k + 1) * length / (n + 1)
+        int64_t states = total_dots + 1;
+        int64_t k = std::min<int64_t>((now - start) * states / length, total_dots);
+        if (k != filled_dots)
         {
-            return false;
+            filled_dots = static_cast<int>(k);
+            if (redraw)
+                queue_redraw();
         }
-        return true;
+
+        // First ms at which state k + 1 begins (the period end wraps to 0)
+        int64_t next = start + ((k + 1) * length + states - 1) / states;
+        int64_t delay = std::max<int64_t>(1, next - now);
+        timer_id = add_timer(static_cast<guint>(std::min<int64_t>(delay, G_MAXUINT)), on_change_static, this);
+    }
+
+    static gboolean on_click_static(GtkWidget *widget, GdkEventButton *event, gpointer data)
+    {
+        auto *self = static_cast<SpeakerGrillCounter *>(data);
+        if (event->type != GDK_BUTTON_PRESS)
+            return FALSE;
+        self->acknowledge_tap(event);
+        self->restart();
+        return TRUE;
+    }
+
+    static gboolean on_change_static(gpointer data)
+    {
+        auto *self = static_cast<SpeakerGrillCounter *>(data);
+        self->timer_id = 0;
+        self->update();
+        return FALSE;
     }
 };
@@ -3,9 +3,11 @@
 #include <cmath>
 #include <vector>
 #include <utility>
+#include <string.h>
 #include <gtk/gtk.h>
 #include "SpeakerGrill.h"
 #include "HapticFeedback.h"
+#include "BinLog.h"
 
 struct Dot
 {
@@ -23,7 +25,7 @@ public:
         : SpeakerGrill(col_, row_, width_blocks_, height_blocks_, radius_,
                        total_blocks_x_, total_blocks_y_)
     {
-        std::srand(std::time(NULL));
+        std::srand(Clock::get()->wall_time());
         gtk_widget_set_events(gtkWidget, GDK_BUTTON_PRESS_MASK);
         g_signal_connect(G_OBJECT(gtkWidget), "button-press-event",
                          G_CALLBACK(on_click_static), this);
@@ -36,11 +38,49 @@ public:
         on_click(gtkWidget, &ev);
     }
 
-protected:
-    gboolean on_expose(GtkWidget *widget, GdkEventExpose *event) override
+    const char *type_name() const override { return "SpeakerGrillDice"; }
+
+    uint64_t state_hash() const override
+    {
+        if (show_noise || animation_timer)
+            return 0; // random noise / moving dots
+        int state[2] = {radius, last_roll};
+        return hash_bytes(state, sizeof(state));
+    }
+
+    size_t save_state(uint8_t *out, size_t max) const override
+    {
+        int32_t roll = last_roll;
+        memcpy(out, &roll, sizeof(roll));
+        return sizeof(roll);
+    }
+
+    void restore_state(const uint8_t *in, size_t len) override
     {
-        cairo_t *cr = gdk_cairo_create(widget->window);
+        int32_t roll;
+        if (len != sizeof(roll))
+            return;
+        memcpy(&roll, in, sizeof(roll));
+        if (roll < 1 || roll > 6)
+            return;
 
+        // Cancel the startup roll and show the restored face directly
+        last_roll = roll;
+        settle();
+    }
+
+    // Nobody sees the roll animate: jump to the final face
+    void on_display_off() override
+    {
+        if (noise_timer || reveal_timer || animation_timer)
+            settle();
+    }
+
+protected:
+    // Noise and moving dots have state_hash() 0, so only settled faces are
+    // kept in the TileCache
+    void draw(cairo_t *cr, int width, int height) override
+    {
         if (show_noise)
         {
             // Draw rolling noise: random squares
@@ -48,14 +88,17 @@ protected:
             int square_size = radius;
             for (int i = 0; i < 30; i++)
             {
-                double x = std::rand() % (widget->allocation.width - square_size);
-                double y = std::rand() % (widget->allocation.height - square_size);
+                double x = std::rand() % (width - square_size);
+                double y = std::rand() % (height - square_size);
                 cairo_rectangle(cr, x, y, square_size, square_size);
                 cairo_fill(cr);
             }
         }
         else
         {
+            if (dots.empty())
+                place_dots();
+
             // Draw final dice dots
             cairo_set_source_rgb(cr, 0, 0, 0);
             for (auto &d : dots)
@@ -64,15 +107,13 @@ protected:
                 cairo_fill(cr);
             }
         }
-
-        cairo_destroy(cr);
-        return FALSE;
     }
 
 private:
     std::vector<Dot> dots;
     guint animation_timer = 0;
     guint noise_timer = 0;
+    guint reveal_timer = 0;
     bool show_noise = false;
 
     // Timer for animation
@@ -103,10 +144,11 @@ private:
             }
         }
 
-        gtk_widget_queue_draw(gtkWidget);
+        queue_redraw(REFRESH_INTERACTIVE);
 
         if (!moving)
         {
+            Trace::record(trace_id, TRACE_SPAN_END, "animation");
             animation_timer = 0;
             return FALSE; // stop
         }
@@ -121,7 +163,7 @@ private:
 
     gboolean show_noise_step()
     {
-        gtk_widget_queue_draw(gtkWidget);
+        queue_redraw(REFRESH_INTERACTIVE);
         return TRUE; // keep noise drawing until stopped
     }
 
@@ -183,24 +225,35 @@ private:
     {
         if (event->type == GDK_BUTTON_PRESS)
         {
-            HapticFeedback::play_sequence({HapticFeedback::SHARP_CLICK, HapticFeedback::LONG_BUZZ, HapticFeedback::SHARP_CLICK}, 50);
+            acknowledge_tap(event); // before the haptics block the thread
+            {
+                TraceSpan span(trace_id, "haptics");
+                HapticFeedback::play_sequence({HapticFeedback::SHARP_CLICK, HapticFeedback::LONG_BUZZ, HapticFeedback::SHARP_CLICK}, 50);
+            }
             int roll = (std::rand() % 6) + 1;
-            g_print("🎲 Rolling... -> %d\n", roll);
+            BINLOG("[DICE] rolled %d", roll);
 
             // Show noise first
+            if (!show_noise)
+                Trace::record(trace_id, TRACE_SPAN_BEGIN, "noise");
             show_noise = true;
             if (noise_timer == 0)
-                noise_timer = g_timeout_add(80, noise_static, this); // refresh noise
+                noise_timer = add_timer(80, noise_static, this); // refresh noise
 
             // After delay, stop noise and animate dice face
-            g_timeout_add(1200, [](gpointer data) -> gboolean
+            if (reveal_timer)
+                remove_timer(reveal_timer);
+            reveal_timer = add_timer(1200, [](gpointer data) -> gboolean
                           {
                               auto *self = static_cast<SpeakerGrillDice *>(data);
+                              self->reveal_timer = 0;
                               if (self->noise_timer)
                               {
-                                  g_source_remove(self->noise_timer);
+                                  self->remove_timer(self->noise_timer);
                                   self->noise_timer = 0;
                               }
+                              if (self->show_noise)
+                                  Trace::record(self->trace_id, TRACE_SPAN_END, "noise");
                               self->show_noise = false;
 
                               // prepare final positions
@@ -219,16 +272,51 @@ private:
                               }
 
                               if (self->animation_timer == 0)
-                                  self->animation_timer = g_timeout_add(16, animate_static, self);
+                              {
+                                  Trace::record(self->trace_id, TRACE_SPAN_BEGIN, "animation");
+                                  self->animation_timer = self->add_timer(16, animate_static, self);
+                              }
 
                               return FALSE; // run once
                           },
                           this);
 
             last_roll = roll;
+            persist_state();
         }
         return TRUE;
     }
 
+    // Stop noise / animation and show last_roll's face directly
+    void settle()
+    {
+        stop_timer(noise_timer);
+        stop_timer(reveal_timer);
+        if (show_noise)
+            Trace::record(trace_id, TRACE_SPAN_END, "noise");
+        show_noise = false;
+        if (animation_timer)
+            Trace::record(trace_id, TRACE_SPAN_END, "animation");
+        stop_timer(animation_timer);
+
+        dots.clear(); // laid out at the next expose, once the size is known
+        queue_redraw();
+    }
+
+    // Dots at their final positions, without animation
+    void place_dots()
+    {
+        int w = gtkWidget->allocation.width;
+        int h = gtkWidget->allocation.height;
+        auto pos = dice_positions(last_roll, w, h);
+
+        dots.resize(pos.size());
+        for (size_t i = 0; i < pos.size(); i++)
+        {
+            dots[i].x = dots[i].tx = pos[i].first;
+            dots[i].y = dots[i].ty = pos[i].second;
+        }
+    }
+
     int last_roll = 1;
 };
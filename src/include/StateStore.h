@@ -0,0 +1,281 @@
+#pragma once
+#include <gtk/gtk.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stddef.h>
+#include <string.h>
+#include <algorithm>
+#include <string>
+#include <map>
+#include <set>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "Clock.h"
+#include "BinLog.h"
+
+// ----------------- StateStore -----------------
+// Versioned, fixed-layout binary store for widget state that must survive a
+// restart. The file is an append-only log of StateRecord entries: restoring
+// is one mmap + scan (latest valid record per key wins), and writes only
+// append. Changes are coalesced in memory and flushed at most every
+// flush_interval_s; once the log holds too many superseded records it is
+// compacted into a fresh file (write + rename), keeping flash writes low.
+//
+// File layout: StateFileHeader, then StateRecord entries.
+
+#pragma pack(push, 1)
+struct StateFileHeader
+{
+    uint32_t magic; // 'DWST'
+    uint16_t version;
+    uint16_t record_size;
+};
+
+struct StateRecord
+{
+    static constexpr size_t PAYLOAD_SIZE = 496;
+
+    uint32_t key;
+    uint32_t sequence;
+    uint16_t version; // payload layout version, owned by the writer
+    uint16_t length;  // bytes used in payload
+    uint8_t payload[PAYLOAD_SIZE];
+    uint32_t crc;     // over all fields above; torn appends fail the check
+};
+#pragma pack(pop)
+
+static_assert(sizeof(StateRecord) == 512, "StateRecord must stay 512 bytes");
+
+class StateStore
+{
+public:
+    static constexpr uint32_t MAGIC = 0x54535744; // "DWST"
+    static constexpr uint16_t VERSION = 1;
+
+    StateStore(const std::string &path_, guint flush_interval_s_ = 30)
+        : path(path_), fd(-1), sequence(0), appended(0), loaded(false),
+          flush_interval_s(flush_interval_s_), flush_id(0)
+    {
+        load();
+        fd = open_log();
+    }
+
+    ~StateStore()
+    {
+        if (flush_id > 0)
+            Clock::get()->remove(flush_id);
+        flush();
+        if (fd >= 0)
+            close(fd);
+    }
+
+    StateStore(const StateStore &) = delete;
+    StateStore &operator=(const StateStore &) = delete;
+
+    // Latest payload for `key`, if one with a matching version exists
+    bool get(uint32_t key, uint16_t version, const uint8_t **data, size_t *len) const
+    {
+        auto it = latest.find(key);
+        if (it == latest.end() || it->second.version != version)
+            return false;
+        *data = it->second.payload;
+        *len = it->second.length;
+        return true;
+    }
+
+    // Record a new value; identical values are dropped, others are flushed
+    // together after flush_interval_s
+    void put(uint32_t key, uint16_t version, const void *data, size_t len)
+    {
+        if (len > StateRecord::PAYLOAD_SIZE)
+            return;
+
+        auto it = latest.find(key);
+        if (it != latest.end() && it->second.version == version &&
+            it->second.length == len && memcmp(it->second.payload, data, len) == 0)
+            return;
+
+        StateRecord &rec = latest[key];
+        memset(&rec, 0, sizeof(rec));
+        rec.key = key;
+        rec.version = version;
+        rec.length = static_cast<uint16_t>(len);
+        memcpy(rec.payload, data, len);
+        dirty.insert(key);
+
+        if (!flush_id)
+            flush_id = Clock::get()->add_timeout(flush_interval_s * 1000, on_flush_static, this);
+    }
+
+    // Append all pending records (one write call)
+    void flush()
+    {
+        if (dirty.empty() || fd < 0)
+            return;
+
+        std::string buf;
+        std::vector<uint32_t> keys(dirty.begin(), dirty.end());
+        for (uint32_t key : keys)
+        {
+            StateRecord &rec = latest[key];
+            rec.sequence = ++sequence;
+            rec.crc = crc32(&rec, offsetof(StateRecord, crc));
+            buf.append(reinterpret_cast<const char *>(&rec), sizeof(rec));
+        }
+        dirty.clear();
+
+        ssize_t n = write(fd, buf.data(), buf.size());
+        size_t whole = n > 0 ? static_cast<size_t>(n) / sizeof(StateRecord) : 0;
+        appended += whole;
+        if (whole < keys.size())
+        {
+            // Short write (flash full): cut the partial record off so later
+            // appends stay on the record grid, and keep the rest pending
+            if (n < 0)
+                BINLOG("[STATE] append failed, errno %d", errno);
+            else
+                BINLOG("[STATE] short append, %zu of %zu records written", whole, keys.size());
+            off_t aligned = sizeof(StateFileHeader) + (off_t)appended * sizeof(StateRecord);
+            if (n > 0 && ftruncate(fd, aligned) != 0)
+                BINLOG("[STATE] truncate failed, errno %d", errno);
+            dirty.insert(keys.begin() + whole, keys.end());
+            return;
+        }
+
+        // Compact once superseded records clearly outnumber live ones
+        if (appended > latest.size() * 4 + 64)
+            compact();
+    }
+
+private:
+    std::string path;
+    int fd;
+    uint32_t sequence;
+    size_t appended; // records in the log file
+    bool loaded;     // existing file had a compatible header
+    guint flush_interval_s;
+    guint flush_id;
+    std::map<uint32_t, StateRecord> latest;
+    std::set<uint32_t> dirty;
+
+    static uint32_t crc32(const void *data, size_t len)
+    {
+        const uint8_t *p = static_cast<const uint8_t *>(data);
+        uint32_t crc = 0xFFFFFFFFu;
+        for (size_t i = 0; i < len; i++)
+        {
+            crc ^= p[i];
+            for (int k = 0; k < 8; k++)
+                crc = (crc >> 1) ^ (0xEDB88320u & (0u - (crc & 1)));
+        }
+        return ~crc;
+    }
+
+    // Single mmap of the log; keep the newest valid record of every key
+    void load()
+    {
+        int rfd = open(path.c_str(), O_RDONLY);
+        if (rfd < 0)
+            return;
+
+        struct stat st;
+        if (fstat(rfd, &st) < 0 || st.st_size < (off_t)sizeof(StateFileHeader))
+        {
+            close(rfd);
+            return;
+        }
+
+        void *mem = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, rfd, 0);
+        close(rfd);
+        if (mem == MAP_FAILED)
+            return;
+
+        auto *header = static_cast<const StateFileHeader *>(mem);
+        if (header->magic == MAGIC && header->version == VERSION &&
+            header->record_size == sizeof(StateRecord))
+        {
+            auto *rec = reinterpret_cast<const StateRecord *>(header + 1);
+            size_t count = (st.st_size - sizeof(StateFileHeader)) / sizeof(StateRecord);
+            for (size_t i = 0; i < count; i++, rec++)
+            {
+                if (rec->length > StateRecord::PAYLOAD_SIZE ||
+                    rec->crc != crc32(rec, offsetof(StateRecord, crc)))
+                    continue;
+                auto it = latest.find(rec->key);
+                if (it == latest.end() || it->second.sequence < rec->sequence)
+                    latest[rec->key] = *rec;
+                sequence = std::max(sequence, rec->sequence);
+            }
+            appended = count;
+            loaded = true;
+        }
+
+        munmap(mem, st.st_size);
+    }
+
+    int open_log()
+    {
+        int wfd = open(path.c_str(), O_WRONLY | O_APPEND | O_CREAT, 0644);
+        if (wfd < 0)
+            return -1;
+
+        if (!loaded)
+        {
+            // New or incompatible file: start over with a fresh header
+            if (ftruncate(wfd, 0) == 0)
+            {
+                StateFileHeader header{MAGIC, VERSION, sizeof(StateRecord)};
+                ssize_t n = write(wfd, &header, sizeof(header));
+                (void)n;
+            }
+            appended = 0;
+            return wfd;
+        }
+
+        // Drop a torn trailing record so later appends stay aligned
+        off_t aligned = sizeof(StateFileHeader) + (off_t)appended * sizeof(StateRecord);
+        struct stat st;
+        if (fstat(wfd, &st) == 0 && st.st_size != aligned && ftruncate(wfd, aligned) != 0)
+            BINLOG("[STATE] truncate failed, errno %d", errno);
+        return wfd;
+    }
+
+    // Rewrite the log with only the latest record per key
+    void compact()
+    {
+        std::string tmp = path + ".tmp";
+        FILE *f = fopen(tmp.c_str(), "wb");
+        if (!f)
+            return;
+
+        StateFileHeader header{MAGIC, VERSION, sizeof(StateRecord)};
+        bool ok = fwrite(&header, sizeof(header), 1, f) == 1;
+        for (auto &entry : latest)
+            ok = ok && fwrite(&entry.second, sizeof(StateRecord), 1, f) == 1;
+        ok = (fflush(f) == 0) && ok;
+        fsync(fileno(f));
+        ok = (fclose(f) == 0) && ok;
+
+        if (!ok || rename(tmp.c_str(), path.c_str()) != 0)
+        {
+            unlink(tmp.c_str());
+            return;
+        }
+
+        close(fd);
+        fd = open(path.c_str(), O_WRONLY | O_APPEND);
+        appended = latest.size();
+    }
+
+    static gboolean on_flush_static(gpointer data)
+    {
+        auto *self = static_cast<StateStore *>(data);
+        self->flush_id = 0;
+        self->flush();
+        return FALSE;
+    }
+};
@@ -0,0 +1,218 @@
+#pragma once
+#include <gtk/gtk.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <string>
+#include "ModularWidget.h"
+#include "Clock.h"
+#include "TileCache.h"
+#include "MemoryBudget.h"
+#include "BinLog.h"
+
+// ----------------- StatsServer -----------------
+// Process-wide report of every ModularWidget's WidgetStats.
+//  - Query: connect to the UNIX socket and read a text table, e.g.
+//      socat - UNIX-CONNECT:/tmp/dynamic-widget-stats.sock
+//  - Log: every dump_interval_s a compact binary snapshot is appended to
+//    log_path (layout below), so fleet devices can ship it later.
+//
+// Binary log layout (little endian, all fields packed):
+//   StatsLogHeader, then `count` StatsLogRecord entries
+
+#pragma pack(push, 1)
+struct StatsLogHeader
+{
+    uint32_t magic; // 'DWS1'
+    uint32_t timestamp;
+    uint16_t count;
+};
+
+struct StatsLogRecord
+{
+    uint16_t id;
+    char type[20];
+    uint32_t expose_calls;
+    uint32_t render_ms;
+    uint32_t invalidated_kb;
+    uint32_t wakeups;
+    uint32_t label_updates;
+};
+#pragma pack(pop)
+
+class StatsServer
+{
+public:
+    static constexpr uint32_t LOG_MAGIC = 0x31535744; // "DWS1"
+
+    StatsServer(const char *socket_path_ = "/tmp/dynamic-widget-stats.sock",
+                const char *log_path_ = "/tmp/dynamic-widget-stats.bin",
+                guint dump_interval_s = 300)
+        : socket_path(socket_path_), log_path(log_path_), listen_fd(-1), watch_id(0), dump_id(0)
+    {
+        listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (listen_fd < 0)
+        {
+            BINLOG("[STATS] socket failed, errno %d", errno);
+            return;
+        }
+
+        struct sockaddr_un addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sun_family = AF_UNIX;
+        strncpy(addr.sun_path, socket_path.c_str(), sizeof(addr.sun_path) - 1);
+        unlink(socket_path.c_str());
+
+        if (bind(listen_fd, (struct sockaddr *)&addr, sizeof(addr)) < 0 || listen(listen_fd, 4) < 0)
+        {
+            BINLOG("[STATS] bind failed, errno %d", errno);
+            close(listen_fd);
+            listen_fd = -1;
+        }
+        else
+        {
+            fcntl(listen_fd, F_SETFL, O_NONBLOCK);
+            GIOChannel *ch = g_io_channel_unix_new(listen_fd);
+            watch_id = g_io_add_watch(ch, G_IO_IN, on_accept_static, this);
+            g_io_channel_unref(ch);
+        }
+
+        if (dump_interval_s > 0)
+            dump_id = Clock::get()->add_timeout(dump_interval_s * 1000, on_dump_static, this);
+    }
+
+    ~StatsServer()
+    {
+        if (watch_id > 0) g_source_remove(watch_id);
+        if (dump_id > 0) Clock::get()->remove(dump_id);
+        if (listen_fd >= 0)
+        {
+            close(listen_fd);
+            unlink(socket_path.c_str());
+        }
+    }
+
+    // Human-readable table of all widgets
+    static std::string report()
+    {
+        std::string out = "id type                 exposes  render_ms   inval_kb  wakeups   labels\n";
+        char line[200];
+        for (ModularWidget *w : ModularWidget::instances())
+        {
+            const WidgetStats &s = w->stats;
+            snprintf(line, sizeof(line), "%2d %-20s %8u %10llu %10llu %8u %8u\n",
+                     w->trace_id, w->type_name(), s.expose_calls,
+                     static_cast<unsigned long long>(s.render_us / 1000),
+                     static_cast<unsigned long long>(s.invalidated_bytes / 1024),
+                     s.wakeups, s.label_updates);
+            out += line;
+        }
+        const TileCache &tiles = TileCache::get();
+        snprintf(line, sizeof(line), "tile cache: %zu tiles, %zu kb, hits %llu misses %llu (%.0f%%), evicted %llu\n",
+                 tiles.tiles(), tiles.bytes / 1024, static_cast<unsigned long long>(tiles.hits),
+                 static_cast<unsigned long long>(tiles.misses), tiles.hit_rate() * 100,
+                 static_cast<unsigned long long>(tiles.evictions));
+        out += line;
+
+        const RefreshScheduler &sched = RefreshScheduler::get();
+        snprintf(line, sizeof(line),
+                 "refresh: interactive %llu, time-critical %llu, background %llu (merged %llu, at deadline %llu, waiting %zu), fast updates %llu\n",
+                 static_cast<unsigned long long>(sched.requests[REFRESH_INTERACTIVE]),
+                 static_cast<unsigned long long>(sched.requests[REFRESH_TIME_CRITICAL]),
+                 static_cast<unsigned long long>(sched.requests[REFRESH_BACKGROUND]),
+                 static_cast<unsigned long long>(sched.merged), static_cast<unsigned long long>(sched.forced),
+                 sched.pending(), static_cast<unsigned long long>(sched.fast_updates));
+        out += line;
+
+        out += "ghosting: id type                  score threshold  partials     gray  flashes\n";
+        for (ModularWidget *w : ModularWidget::instances())
+        {
+            const GhostStats &g = w->ghost;
+            snprintf(line, sizeof(line), "          %2d %-20s %6.1f %9.1f %9u %8u %8u\n",
+                     w->trace_id, w->type_name(), g.score, g.effective_threshold(),
+                     g.partials, g.gray_transitions, g.flashes);
+            out += line;
+        }
+
+        const MemoryBudget &mem = MemoryBudget::get();
+        snprintf(line, sizeof(line), "memory: %zu of %zu kb, pressure events %llu (%s)\n",
+                 mem.total_bytes() / 1024, mem.budget_bytes / 1024,
+                 static_cast<unsigned long long>(mem.pressure_events), mem.has_psi() ? "psi" : "meminfo");
+        out += line;
+        for (const MemoryBudget::Account &a : mem.all())
+        {
+            snprintf(line, sizeof(line), "  %-12s %8zu kb, evicted %llu (%llu kb)\n",
+                     a.consumer->memory_name(), a.consumer->memory_bytes() / 1024,
+                     static_cast<unsigned long long>(a.evictions),
+                     static_cast<unsigned long long>(a.evicted_bytes / 1024));
+            out += line;
+        }
+        return out;
+    }
+
+    // Append one binary snapshot to the log
+    bool dump()
+    {
+        FILE *f = fopen(log_path.c_str(), "ab");
+        if (!f)
+            return false;
+
+        auto &all = ModularWidget::instances();
+        StatsLogHeader header{LOG_MAGIC, static_cast<uint32_t>(Clock::get()->wall_time()),
+                              static_cast<uint16_t>(all.size())};
+        fwrite(&header, sizeof(header), 1, f);
+
+        for (ModularWidget *w : all)
+        {
+            StatsLogRecord rec;
+            memset(&rec, 0, sizeof(rec));
+            rec.id = static_cast<uint16_t>(w->trace_id);
+            strncpy(rec.type, w->type_name(), sizeof(rec.type) - 1);
+            rec.expose_calls = w->stats.expose_calls;
+            rec.render_ms = static_cast<uint32_t>(w->stats.render_us / 1000);
+            rec.invalidated_kb = static_cast<uint32_t>(w->stats.invalidated_bytes / 1024);
+            rec.wakeups = w->stats.wakeups;
+            rec.label_updates = w->stats.label_updates;
+            fwrite(&rec, sizeof(rec), 1, f);
+        }
+
+        fclose(f);
+        return true;
+    }
+
+private:
+    std::string socket_path;
+    std::string log_path;
+    int listen_fd;
+    guint watch_id;
+    guint dump_id;
+
+    static gboolean on_accept_static(GIOChannel *source, GIOCondition condition, gpointer data)
+    {
+        auto *self = static_cast<StatsServer *>(data);
+        int client;
+        while ((client = accept(self->listen_fd, NULL, NULL)) >= 0)
+        {
+            // One non-blocking send: the report fits the socket buffer, and
+            // a client that stalls or is already gone must neither block
+            // the main loop nor raise SIGPIPE (it would get a short report)
+            fcntl(client, F_SETFL, O_NONBLOCK);
+            std::string text = report();
+            ssize_t n = send(client, text.data(), text.size(), MSG_NOSIGNAL);
+            (void)n;
+            close(client);
+        }
+        return TRUE;
+    }
+
+    static gboolean on_dump_static(gpointer data)
+    {
+        static_cast<StatsServer *>(data)->dump();
+        return TRUE;
+    }
+};
@@ -0,0 +1,93 @@
+#pragma once
+#include <gtk/gtk.h>
+#include <stdint.h>
+#include <math.h>
+#include <algorithm>
+#include "EinkPanel.h"
+
+// ----------------- TapAck -----------------
+// Acknowledgement mark for a tap: a small black ring, rendered once.
+// show() puts it on the panel right from the input handler, before any
+// state change, redraw or blocking work. On a Kindle, the mark is written
+// straight into the framebuffer and refreshed with DU (black/white, no
+// flash), so it bypasses GTK and the X server. Elsewhere, it is drawn on
+// the widget's window and flushed. The widget's next normal redraw paints
+// over it.
+class TapAck
+{
+public:
+    static constexpr int SIZE = 24;
+
+    // Show the mark centered on (root_x, root_y); false if nothing was drawn
+    static bool show(GtkWidget *widget, int root_x, int root_y)
+    {
+        int x = root_x - SIZE / 2, y = root_y - SIZE / 2;
+        EinkPanel &panel = EinkPanel::get();
+        if (panel.is_open())
+        {
+            int ux = std::max(0, x), uy = std::max(0, y);
+            int uw = std::min(x + SIZE, panel.width) - ux, uh = std::min(y + SIZE, panel.height) - uy;
+            if (uw <= 0 || uh <= 0)
+                return false;
+            return panel.blit_gray8(x, y, SIZE, SIZE, mark(), SIZE) &&
+                   panel.send_update(ux, uy, uw, uh, EinkPanel::WAVEFORM_DU, false);
+        }
+
+        if (!widget->window)
+            return false;
+        int ox, oy;
+        gdk_window_get_origin(widget->window, &ox, &oy);
+        cairo_t *cr = gdk_cairo_create(widget->window);
+        cairo_set_source_surface(cr, mark_surface(), x - ox, y - oy);
+        cairo_paint(cr);
+        cairo_destroy(cr);
+        gdk_flush();
+        return true;
+    }
+
+private:
+    // SIZE x SIZE gray8, white around a black ring
+    static const uint8_t *mark()
+    {
+        static uint8_t pixels[SIZE * SIZE];
+        static bool rendered = false;
+        if (!rendered)
+        {
+            double c = (SIZE - 1) / 2.0;
+            for (int j = 0; j < SIZE; j++)
+            {
+                for (int i = 0; i < SIZE; i++)
+                {
+                    double d = hypot(i - c, j - c);
+                    pixels[j * SIZE + i] = d >= SIZE / 2.0 - 5 && d <= SIZE / 2.0 - 1 ? 0x00 : 0xFF;
+                }
+            }
+            rendered = true;
+        }
+        return pixels;
+    }
+
+    static cairo_surface_t *mark_surface()
+    {
+        static cairo_surface_t *surface = nullptr;
+        if (!surface)
+        {
+            surface = cairo_image_surface_create(CAIRO_FORMAT_RGB24, SIZE, SIZE);
+            cairo_surface_flush(surface);
+            uint8_t *data = cairo_image_surface_get_data(surface);
+            int stride = cairo_image_surface_get_stride(surface);
+            const uint8_t *gray = mark();
+            for (int j = 0; j < SIZE; j++)
+            {
+                uint32_t *row = reinterpret_cast<uint32_t *>(data + j * stride);
+                for (int i = 0; i < SIZE; i++)
+                {
+                    uint32_t v = gray[j * SIZE + i];
+                    row[i] = v << 16 | v << 8 | v;
+                }
+            }
+            cairo_surface_mark_dirty(surface);
+        }
+        return surface;
+    }
+};
@@ -0,0 +1,114 @@
+#pragma once
+#include <gtk/gtk.h>
+#include <string.h>
+#include <initializer_list>
+
+// ----------------- TextStyle -----------------
+// A label style built once: the font description and the PangoAttrList are
+// created in the constructor and attached to labels with apply(). Updates then
+// only swap the plain text, so Pango never re-parses markup on the hot path.
+class TextStyle
+{
+public:
+    PangoFontDescription *font;
+    PangoAttrList *attrs;
+
+    // size is in Pango units, same as the old <span size='...'> values
+    TextStyle(int size, PangoWeight weight = PANGO_WEIGHT_NORMAL,
+              PangoStyle style = PANGO_STYLE_NORMAL)
+    {
+        font = pango_font_description_new();
+        pango_font_description_set_size(font, size);
+        pango_font_description_set_weight(font, weight);
+        pango_font_description_set_style(font, style);
+
+        attrs = pango_attr_list_new();
+        pango_attr_list_insert(attrs, pango_attr_font_desc_new(font));
+    }
+
+    ~TextStyle()
+    {
+        pango_attr_list_unref(attrs);
+        pango_font_description_free(font);
+    }
+
+    TextStyle(const TextStyle &) = delete;
+    TextStyle &operator=(const TextStyle &) = delete;
+
+    // Attach the style to a label once; set_text() keeps it afterwards
+    void apply(GtkWidget *label) const
+    {
+        gtk_label_set_attributes(GTK_LABEL(label), attrs);
+    }
+
+    // Replace only the text, skipping the relayout when nothing changed.
+    // Returns true if the label was updated.
+    static bool set_text(GtkWidget *label, const char *text)
+    {
+        const char *current = gtk_label_get_text(GTK_LABEL(label));
+        if (current && strcmp(current, text) == 0)
+            return false;
+        gtk_label_set_text(GTK_LABEL(label), text);
+        return true;
+    }
+};
+
+// ----------------- TextTemplate -----------------
+// Several styled runs inside one label (e.g. "HH:MM" bold + ":SS" small).
+// The byte length of every run is fixed when the template is built, so the
+// text passed to set_text() must keep the same layout (fixed-width fields).
+struct TextRun
+{
+    int bytes;
+    int size = 0; // 0 leaves the run unstyled
+    PangoWeight weight = PANGO_WEIGHT_NORMAL;
+    PangoStyle style = PANGO_STYLE_NORMAL;
+};
+
+class TextTemplate
+{
+public:
+    PangoAttrList *attrs;
+
+    TextTemplate(std::initializer_list<TextRun> runs)
+        : attrs(pango_attr_list_new()), length(0)
+    {
+        for (const TextRun &run : runs)
+            add_run(run);
+    }
+
+    ~TextTemplate()
+    {
+        pango_attr_list_unref(attrs);
+    }
+
+    TextTemplate(const TextTemplate &) = delete;
+    TextTemplate &operator=(const TextTemplate &) = delete;
+
+    void apply(GtkWidget *label) const
+    {
+        gtk_label_set_attributes(GTK_LABEL(label), attrs);
+    }
+
+private:
+    void add_run(const TextRun &run)
+    {
+        if (run.size > 0)
+        {
+            PangoFontDescription *font = pango_font_description_new();
+            pango_font_description_set_size(font, run.size);
+            pango_font_description_set_weight(font, run.weight);
+            pango_font_description_set_style(font, run.style);
+
+            // The attribute keeps its own copy of the description
+            PangoAttribute *attr = pango_attr_font_desc_new(font);
+            attr->start_index = length;
+            attr->end_index = length + run.bytes;
+            pango_attr_list_insert(attrs, attr);
+            pango_font_description_free(font);
+        }
+        length += run.bytes;
+    }
+
+    guint length;
+};
@@ -0,0 +1,157 @@
+#pragma once
+#include <gtk/gtk.h>
+#include <stdint.h>
+#include <list>
+#include <unordered_map>
+#include "MemoryBudget.h"
+#include "Trace.h"
+
+// Renders one tile: content for width x height at the origin of `cr`
+typedef void (*TileDrawFunc)(cairo_t *cr, int width, int height, gpointer data);
+
+// ----------------- TileCache -----------------
+// Finished widget renderings, keyed by (widget type, state_hash, size).
+// Widgets whose state cycles through a few values (battery levels, dice
+// faces, fill levels) render each state once into a transparent ARGB32
+// tile; when the state recurs the tile is painted instead of re-running
+// the path and text work. Least recently used tiles go first once the
+// byte budget is exceeded, or when MemoryBudget picks the oldest tile as
+// the cheapest thing in the process to give back.
+class TileCache : public MemoryConsumer
+{
+public:
+    size_t budget_bytes = 2 * 1024 * 1024;
+
+    // Counters for reports
+    uint64_t hits = 0, misses = 0, evictions = 0;
+    size_t bytes = 0;
+
+    static TileCache &get()
+    {
+        static TileCache cache;
+        return cache;
+    }
+
+    // Paint the tile for (type, state, width x height) at the origin of
+    // `cr`, rendering it with `draw` on a miss. State 0 ("unknown") and
+    // oversized tiles bypass the cache and draw directly.
+    void paint(cairo_t *cr, const char *type, uint64_t state, int width, int height,
+               TileDrawFunc draw, gpointer data)
+    {
+        size_t tile_bytes = static_cast<size_t>(width) * height * 4;
+        if (state == 0 || width <= 0 || height <= 0 || tile_bytes > budget_bytes / 4)
+        {
+            draw(cr, width, height, data);
+            return;
+        }
+
+        Key key{type, state, width, height};
+        auto it = index.find(key);
+        cairo_surface_t *tile;
+        bool miss = it == index.end();
+        if (!miss)
+        {
+            hits++;
+            lru.splice(lru.begin(), lru, it->second); // most recent first
+            tile = it->second->tile;
+        }
+        else
+        {
+            misses++;
+            int64_t start = Trace::now_us();
+            tile = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, width, height);
+            cairo_t *tcr = cairo_create(tile);
+            draw(tcr, width, height, data);
+            cairo_destroy(tcr);
+            cairo_surface_flush(tile);
+
+            lru.push_front(Entry{key, tile, tile_bytes, Trace::now_us() - start});
+            index[key] = lru.begin();
+            bytes += tile_bytes;
+            trim(budget_bytes);
+        }
+
+        cairo_set_source_surface(cr, tile, 0, 0);
+        cairo_paint(cr);
+        if (miss)
+            MemoryBudget::get().grew();
+    }
+
+    // Drop tiles until at most `target` bytes remain
+    void trim(size_t target)
+    {
+        while (bytes > target && !lru.empty())
+        {
+            Entry &e = lru.back();
+            bytes -= e.bytes;
+            cairo_surface_destroy(e.tile);
+            index.erase(e.key);
+            lru.pop_back();
+            evictions++;
+        }
+    }
+
+    size_t tiles() const { return lru.size(); }
+
+    // MemoryConsumer: the least recently used tile, valued by its render time
+    const char *memory_name() const override { return "tiles"; }
+    size_t memory_bytes() const override { return bytes; }
+
+    bool memory_cheapest(double *cost_per_kb) const override
+    {
+        if (lru.empty())
+            return false;
+        const Entry &e = lru.back();
+        *cost_per_kb = static_cast<double>(e.render_us) * 1024 / e.bytes;
+        return true;
+    }
+
+    size_t memory_evict() override
+    {
+        size_t before = bytes;
+        if (!lru.empty())
+            trim(bytes - lru.back().bytes);
+        return before - bytes;
+    }
+
+    double hit_rate() const
+    {
+        uint64_t total = hits + misses;
+        return total ? static_cast<double>(hits) / total : 0.0;
+    }
+
+private:
+    struct Key
+    {
+        const char *type; // type_name() literals are unique per type
+        uint64_t state;
+        int width, height;
+        bool operator==(const Key &o) const
+        {
+            return type == o.type && state == o.state && width == o.width && height == o.height;
+        }
+    };
+
+    struct KeyHash
+    {
+        size_t operator()(const Key &k) const
+        {
+            uint64_t h = k.state ^ (reinterpret_cast<uintptr_t>(k.type) * 0x9E3779B97F4A7C15ULL);
+            h ^= (static_cast<uint64_t>(k.width) << 32 | static_cast<uint32_t>(k.height)) * 0xC2B2AE3D27D4EB4FULL;
+            return static_cast<size_t>(h ^ (h >> 29));
+        }
+    };
+
+    struct Entry
+    {
+        Key key;
+        cairo_surface_t *tile;
+        size_t bytes;
+        int64_t render_us; // what a miss cost; the rebuild price
+    };
+
+    std::list<Entry> lru;
+    std::unordered_map<Key, std::list<Entry>::iterator, KeyHash> index;
+
+    TileCache() { MemoryBudget::get().add(this); }
+};
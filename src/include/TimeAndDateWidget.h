@@ -3,6 +3,7 @@
 #include <ctime>
 #include <string>
 #include "ModularWidget.h"
+#include "TextStyle.h"
 
 class TimeDateWidget : public ModularWidget
 {
@@ -21,31 +22,59 @@ public:
           timer_id(0)
     {
         gtkWidget = gtk_label_new(NULL);
+        (update_seconds ? seconds_template() : minutes_template()).apply(gtkWidget);
 
         update_time(); // initial display
 
+        schedule();
+
+        initialize();
+    }
+
+    GtkWidget *get_widget() { return gtkWidget; }
+
+    const char *type_name() const override { return "TimeDateWidget"; }
+
+    uint64_t state_hash() const override
+    {
+        const char *shown = gtk_label_get_text(GTK_LABEL(gtkWidget));
+        return hash_bytes(shown, strlen(shown));
+    }
+
+    // Missed minutes are not replayed: show the current time and align to
+    // the next boundary again
+    void on_resume() override
+    {
+        if (timer_id > 0)
+            remove_timer(timer_id);
+        update_time();
+        schedule();
+    }
+
+    void on_display_off() override
+    {
+        stop_timer(timer_id);
+    }
+
+private:
+    void schedule()
+    {
         if (update_seconds)
         {
             update_interval_ms = 1000;
-            timer_id = g_timeout_add(update_interval_ms, on_timeout_static, this);
+            timer_id = add_timer(update_interval_ms, on_timeout_static, this);
         }
         else
         {
             // compute time until next minute boundary
-            time_t now = time(nullptr);
-            struct tm *t = localtime(&now);
-            int ms_until_next_min = (60 - t->tm_sec) * 1000;
+            struct tm t = Clock::get()->local_time();
+            int ms_until_next_min = (60 - t.tm_sec) * 1000;
 
             // first single-shot timeout until next minute boundary
-            g_timeout_add(ms_until_next_min, on_align_to_minute_static, this);
+            timer_id = add_timer(ms_until_next_min, on_align_to_minute_static, this);
         }
-
-        initialize();
     }
 
-    GtkWidget *get_widget() { return gtkWidget; }
-
-private:
     static gboolean on_timeout_static(gpointer data)
     {
         return static_cast<TimeDateWidget *>(data)->update_time();
@@ -60,7 +89,7 @@ private:
 
         // Now schedule regular updates every 60s
         self->update_interval_ms = 60000;
-        self->timer_id = g_timeout_add(self->update_interval_ms, on_timeout_static, self);
+        self->timer_id = self->add_timer(self->update_interval_ms, on_timeout_static, self);
 
         // Do not repeat this one-shot timer
         return FALSE;
@@ -68,29 +97,43 @@ private:
 
     gboolean update_time()
     {
-        time_t now = time(nullptr);
-        struct tm *t = localtime(&now);
+        struct tm tm_now = Clock::get()->local_time();
+        const struct tm *t = &tm_now;
 
-        char buffer[128];
+        // Fixed-width fields: the byte layout must match the templates below
+        char buffer[64];
         if (update_seconds)
         {
-            snprintf(buffer, sizeof(buffer),
-                     "<span size='24000' weight='bold'>%02d:%02d</span>"
-                     "<span size='14000'>:%02d</span>\n"
-                     "<span size='16000' style='italic'>%02d-%02d-%04d</span>",
+            snprintf(buffer, sizeof(buffer), "%02d:%02d:%02d\n%02d-%02d-%04d",
                      t->tm_hour, t->tm_min, t->tm_sec,
                      t->tm_mday, t->tm_mon + 1, t->tm_year + 1900);
         }
         else
         {
-            snprintf(buffer, sizeof(buffer),
-                     "<span size='24000' weight='bold'>%02d:%02d</span>\n"
-                     "<span size='16000' style='italic'>%02d-%02d-%04d</span>",
+            snprintf(buffer, sizeof(buffer), "%02d:%02d\n%02d-%02d-%04d",
                      t->tm_hour, t->tm_min,
                      t->tm_mday, t->tm_mon + 1, t->tm_year + 1900);
         }
 
-        gtk_label_set_markup(GTK_LABEL(gtkWidget), buffer);
+        set_label_text(gtkWidget, buffer);
         return TRUE;
     }
+
+    // "HH:MM" bold, ":SS" small, newline, "DD-MM-YYYY" italic
+    static const TextTemplate &seconds_template()
+    {
+        static const TextTemplate tpl{{5, 24000, PANGO_WEIGHT_BOLD},
+                                      {3, 14000},
+                                      {1},
+                                      {10, 16000, PANGO_WEIGHT_NORMAL, PANGO_STYLE_ITALIC}};
+        return tpl;
+    }
+
+    static const TextTemplate &minutes_template()
+    {
+        static const TextTemplate tpl{{5, 24000, PANGO_WEIGHT_BOLD},
+                                      {1},
+                                      {10, 16000, PANGO_WEIGHT_NORMAL, PANGO_STYLE_ITALIC}};
+        return tpl;
+    }
 };
@@ -0,0 +1,293 @@
+#pragma once
+#include <gtk/gtk.h>
+#include <algorithm>
+#include <atomic>
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+#include <signal.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "BinLog.h"
+
+// ----------------- Trace -----------------
+// Low-overhead event tracing for the input -> update -> layout -> expose ->
+// refresh path. Events go into a fixed lock-free ring (one atomic increment
+// per event, no allocation) and are only formatted when exported as Chrome
+// trace-event JSON (chrome://tracing or ui.perfetto.dev).
+//
+// Export on demand with: kill -USR1 <pid>  (see install_signal_handler)
+
+enum TracePhase : uint8_t
+{
+    TRACE_INPUT,          // button press reached the widget
+    TRACE_UPDATE,         // widget state changed and a redraw was requested
+    TRACE_LAYOUT,         // size-allocate
+    TRACE_EXPOSE_BEGIN,
+    TRACE_EXPOSE_END,
+    TRACE_SPAN_BEGIN,     // named span inside a handler (e.g. haptics)
+    TRACE_SPAN_END,
+    TRACE_REFRESH_SUBMIT, // drawing flushed out of the process
+    TRACE_ACK             // tap acknowledgement on the panel (first pixel)
+};
+
+struct TraceEvent
+{
+    std::atomic<uint32_t> seq; // index + 1 once the slot is fully written
+    uint16_t widget;
+    uint8_t phase;
+    int64_t ts_us;
+    const char *label; // static string, only for spans
+};
+
+class Trace
+{
+public:
+    static constexpr uint32_t RING_SIZE = 8192; // power of two
+    static constexpr int MAX_WIDGETS = 64;
+    static constexpr int HIST_BUCKETS = 24; // log2 buckets of microseconds
+
+    static inline bool enabled = true;
+    static inline const char *export_path = "/tmp/dynamic-widget-trace.json";
+
+    static int64_t now_us()
+    {
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return static_cast<int64_t>(ts.tv_sec) * 1000000 + ts.tv_nsec / 1000;
+    }
+
+    // Widget ids index the name and histogram tables; 0 is "unassigned"
+    static int register_widget(const char *name)
+    {
+        int id = next_widget.fetch_add(1);
+        if (id >= MAX_WIDGETS)
+            return 0;
+        widget_names[id] = name;
+        return id;
+    }
+
+    static void record(int widget, TracePhase phase, const char *label = nullptr)
+    {
+        if (!enabled)
+            return;
+
+        int64_t ts = now_us();
+        uint32_t idx = head.fetch_add(1, std::memory_order_relaxed);
+        TraceEvent &ev = ring[idx & (RING_SIZE - 1)];
+        ev.seq.store(0, std::memory_order_relaxed);
+        ev.widget = static_cast<uint16_t>(widget);
+        ev.phase = phase;
+        ev.ts_us = ts;
+        ev.label = label;
+        ev.seq.store(idx + 1, std::memory_order_release);
+
+        update_latency(widget, phase, ts);
+    }
+
+    // SIGUSR1 writes export_path from the main loop (never from the handler)
+    static void install_signal_handler(int signum = SIGUSR1)
+    {
+        if (pipe(signal_pipe) != 0)
+            return;
+        fcntl(signal_pipe[0], F_SETFL, O_NONBLOCK);
+        fcntl(signal_pipe[1], F_SETFL, O_NONBLOCK);
+
+        GIOChannel *ch = g_io_channel_unix_new(signal_pipe[0]);
+        g_io_add_watch(ch, G_IO_IN, on_signal_pipe_static, NULL);
+        g_io_channel_unref(ch);
+
+        struct sigaction sa = {};
+        sa.sa_handler = on_signal;
+        sa.sa_flags = SA_RESTART;
+        sigaction(signum, &sa, NULL);
+    }
+
+    static bool export_json(const char *path)
+    {
+        FILE *f = fopen(path, "w");
+        if (!f)
+            return false;
+
+        fprintf(f, "{\"traceEvents\":[\n");
+        int last = std::min(next_widget.load(), MAX_WIDGETS);
+        bool first = true;
+        for (int id = 0; id < last; id++)
+        {
+            fprintf(f, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,"
+                       "\"args\":{\"name\":\"%d %s\"}}",
+                    first ? "" : ",\n", id, id, widget_names[id] ? widget_names[id] : "window");
+            first = false;
+        }
+
+        uint32_t end = head.load(std::memory_order_acquire);
+        uint32_t begin = end > RING_SIZE ? end - RING_SIZE : 0;
+        for (uint32_t idx = begin; idx < end; idx++)
+        {
+            const TraceEvent &ev = ring[idx & (RING_SIZE - 1)];
+            if (ev.seq.load(std::memory_order_acquire) != idx + 1)
+                continue; // overwritten or still being written
+            write_event(f, ev, first);
+            first = false;
+        }
+
+        fprintf(f, "\n],\"otherData\":{\"latency_histograms_us\":{");
+        bool first_hist = true;
+        for (int id = 1; id < last; id++)
+        {
+            for (int kind = 0; kind < 3; kind++)
+            {
+                static const char *const kinds[] = {"input_to_refresh", "update_to_refresh", "input_to_ack"};
+                const uint32_t *buckets = kind == 0 ? input_hist[id] : kind == 1 ? update_hist[id] : ack_hist[id];
+                fprintf(f, "%s\"%d %s %s\":[", first_hist ? "" : ",",
+                        id, widget_names[id], kinds[kind]);
+                for (int b = 0; b < HIST_BUCKETS; b++)
+                    fprintf(f, "%s%u", b ? "," : "", buckets[b]);
+                fprintf(f, "]");
+                first_hist = false;
+            }
+        }
+        fprintf(f, "}}}\n");
+        fclose(f);
+        return true;
+    }
+
+private:
+    static inline TraceEvent ring[RING_SIZE];
+    static inline std::atomic<uint32_t> head{0};
+    static inline std::atomic<int> next_widget{1};
+    static inline const char *widget_names[MAX_WIDGETS];
+
+    // Pending start timestamps per widget, consumed at the next refresh
+    static inline int64_t pending_input[MAX_WIDGETS];
+    static inline int64_t pending_update[MAX_WIDGETS];
+    static inline bool exposed[MAX_WIDGETS];
+    static inline uint32_t input_hist[MAX_WIDGETS][HIST_BUCKETS];
+    static inline uint32_t update_hist[MAX_WIDGETS][HIST_BUCKETS];
+    static inline uint32_t ack_hist[MAX_WIDGETS][HIST_BUCKETS];
+    static inline guint refresh_idle = 0;
+    static inline int signal_pipe[2] = {-1, -1};
+
+    static void update_latency(int widget, TracePhase phase, int64_t ts)
+    {
+        if (widget <= 0 || widget >= MAX_WIDGETS)
+            return;
+
+        switch (phase)
+        {
+        case TRACE_INPUT:
+            pending_input[widget] = ts;
+            break;
+        case TRACE_UPDATE:
+            if (!pending_update[widget])
+                pending_update[widget] = ts;
+            break;
+        case TRACE_ACK:
+            // input_to_refresh still waits for the full redraw
+            if (pending_input[widget])
+                add_sample(ack_hist[widget], ts - pending_input[widget]);
+            break;
+        case TRACE_EXPOSE_END:
+            exposed[widget] = true;
+            // The flush happens once the GDK redraw pass is over
+            if (!refresh_idle)
+                refresh_idle = g_idle_add_full(G_PRIORITY_DEFAULT_IDLE, on_refresh_static, NULL, NULL);
+            break;
+        default:
+            break;
+        }
+    }
+
+    static void add_sample(uint32_t *hist, int64_t latency_us)
+    {
+        int bucket = 0;
+        while (latency_us > 1 && bucket < HIST_BUCKETS - 1)
+        {
+            latency_us >>= 1;
+            bucket++;
+        }
+        hist[bucket]++;
+    }
+
+    static gboolean on_refresh_static(gpointer)
+    {
+        refresh_idle = 0;
+        gdk_flush();
+
+        int64_t ts = now_us();
+        int last = std::min(next_widget.load(), MAX_WIDGETS);
+        for (int id = 1; id < last; id++)
+        {
+            if (!exposed[id])
+                continue;
+            exposed[id] = false;
+            record(id, TRACE_REFRESH_SUBMIT);
+
+            if (pending_input[id])
+            {
+                add_sample(input_hist[id], ts - pending_input[id]);
+                pending_input[id] = 0;
+            }
+            if (pending_update[id])
+            {
+                add_sample(update_hist[id], ts - pending_update[id]);
+                pending_update[id] = 0;
+            }
+        }
+        return FALSE;
+    }
+
+    static void on_signal(int)
+    {
+        char c = 1;
+        ssize_t r = write(signal_pipe[1], &c, 1);
+        (void)r;
+    }
+
+    static gboolean on_signal_pipe_static(GIOChannel *source, GIOCondition condition, gpointer data)
+    {
+        char buf[16];
+        while (read(signal_pipe[0], buf, sizeof(buf)) > 0)
+            ;
+        if (export_json(export_path))
+            BINLOG("[TRACE] wrote %s", export_path);
+        return TRUE;
+    }
+
+    static void write_event(FILE *f, const TraceEvent &ev, bool first)
+    {
+        static const char *const names[] = {"input", "update", "layout", "expose", "expose",
+                                            "", "", "refresh-submit", "ack"};
+        const char *name = ev.label ? ev.label : names[ev.phase];
+        const char *ph;
+        switch (ev.phase)
+        {
+        case TRACE_EXPOSE_BEGIN:
+        case TRACE_SPAN_BEGIN:
+            ph = "B";
+            break;
+        case TRACE_EXPOSE_END:
+        case TRACE_SPAN_END:
+            ph = "E";
+            break;
+        default:
+            ph = "i";
+            break;
+        }
+        fprintf(f, "%s{\"name\":\"%s\",\"ph\":\"%s\",\"ts\":%lld,\"pid\":1,\"tid\":%d%s}",
+                first ? "" : ",\n", name, ph, static_cast<long long>(ev.ts_us), ev.widget,
+                ph[0] == 'i' ? ",\"s\":\"t\"" : "");
+    }
+};
+
+// Named span for blocking work inside a handler
+struct TraceSpan
+{
+    int widget;
+    const char *label;
+    TraceSpan(int widget_, const char *label_) : widget(widget_), label(label_)
+    {
+        Trace::record(widget, TRACE_SPAN_BEGIN, label);
+    }
+    ~TraceSpan() { Trace::record(widget, TRACE_SPAN_END, label); }
+};
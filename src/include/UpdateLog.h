@@ -0,0 +1,211 @@
+#pragma once
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <string>
+#include <vector>
+#include "Clock.h"
+#include "BinLog.h"
+
+// ----------------- UpdateLog -----------------
+// Record of everything that drives the widgets from outside: taps and data
+// pushed in (data files, battery readings). Timers are not recorded. Replayed
+// under a VirtualClock that starts at the recorded wall time, they fire
+// exactly as they did, so dynamic-widget-replay turns a field recording into
+// a deterministic benchmark.
+//
+// Recording: DWK_RECORD=<file> dynamic-widget-kindle
+//
+// File layout (little endian, packed): UpdateLogHeader, then per event an
+// UpdateLogEvent followed by `length` payload bytes:
+//   UPDATE_INPUT: UpdateLogInput
+//   UPDATE_DATA:  `count` pairs of NUL-terminated key and value
+// Widgets are identified by ModularWidget::state_key(), so a log replays
+// against the same layout it was recorded with.
+
+#pragma pack(push, 1)
+struct UpdateLogHeader
+{
+    uint32_t magic; // 'DWRL'
+    uint16_t version;
+    uint16_t reserved;
+    int64_t start_wall_ms;
+};
+
+struct UpdateLogEvent
+{
+    uint32_t t_ms;   // Clock time since the recording started
+    uint32_t widget; // state_key()
+    uint8_t kind;
+    uint8_t count;
+    uint16_t length;
+};
+
+struct UpdateLogInput
+{
+    int16_t x, y; // relative to the widget
+    uint8_t button;
+};
+#pragma pack(pop)
+
+enum UpdateKind : uint8_t
+{
+    UPDATE_INPUT = 1,
+    UPDATE_DATA = 2,
+};
+
+class UpdateRecorder
+{
+public:
+    static constexpr uint32_t MAGIC = 0x4C525744; // "DWRL"
+    static constexpr uint16_t VERSION = 1;
+
+    uint64_t events = 0;
+
+    static UpdateRecorder &get()
+    {
+        static UpdateRecorder recorder;
+        return recorder;
+    }
+
+    bool active() const { return file != nullptr; }
+
+    // Start a new recording (replaces `path`)
+    bool open(const char *path)
+    {
+        file = fopen(path, "wb");
+        if (!file)
+        {
+            BINLOG("[RECORD] cannot open %s, errno %d", path, errno);
+            return false;
+        }
+        start_us = Clock::get()->monotonic_us();
+        UpdateLogHeader header{MAGIC, VERSION, 0, Clock::get()->wall_time_ms()};
+        fwrite(&header, sizeof(header), 1, file);
+        fflush(file);
+        BINLOG("[RECORD] recording updates to %s", path);
+        return true;
+    }
+
+    void input(uint32_t widget, int x, int y, int button)
+    {
+        if (!file)
+            return;
+        UpdateLogInput in{static_cast<int16_t>(x), static_cast<int16_t>(y), static_cast<uint8_t>(button)};
+        write(widget, UPDATE_INPUT, 0, &in, sizeof(in));
+    }
+
+    void data(uint32_t widget, const char *const *keys, const char *const *values, int n)
+    {
+        if (!file)
+            return;
+        std::string payload;
+        int count = 0;
+        for (int i = 0; i < n && count < 255; i++)
+        {
+            size_t add = strlen(keys[i]) + strlen(values[i]) + 2;
+            if (payload.size() + add > UINT16_MAX)
+                break; // oversized push: the first fields only
+            payload.append(keys[i]).push_back('\0');
+            payload.append(values[i]).push_back('\0');
+            count++;
+        }
+        write(widget, UPDATE_DATA, static_cast<uint8_t>(count), payload.data(), payload.size());
+    }
+
+private:
+    FILE *file = nullptr;
+    int64_t start_us = 0;
+
+    UpdateRecorder() {}
+
+    // Events are rare (taps, pushes): each reaches the file at once, so a
+    // crash loses nothing before it
+    void write(uint32_t widget, uint8_t kind, uint8_t count, const void *payload, size_t len)
+    {
+        UpdateLogEvent ev{static_cast<uint32_t>((Clock::get()->monotonic_us() - start_us) / 1000),
+                          widget, kind, count, static_cast<uint16_t>(len)};
+        fwrite(&ev, sizeof(ev), 1, file);
+        fwrite(payload, 1, len, file);
+        fflush(file);
+        events++;
+    }
+};
+
+// One decoded event
+struct UpdateLogEntry
+{
+    uint32_t t_ms;
+    uint32_t widget;
+    uint8_t kind;
+    UpdateLogInput input;
+    std::vector<std::string> keys, values;
+};
+
+class UpdateLogReader
+{
+public:
+    int64_t start_wall_ms = 0;
+
+    ~UpdateLogReader()
+    {
+        if (file)
+            fclose(file);
+    }
+
+    bool open(const char *path)
+    {
+        file = fopen(path, "rb");
+        if (!file)
+            return false;
+        UpdateLogHeader header;
+        if (fread(&header, sizeof(header), 1, file) != 1 ||
+            header.magic != UpdateRecorder::MAGIC || header.version != UpdateRecorder::VERSION)
+        {
+            fclose(file);
+            file = nullptr;
+            return false;
+        }
+        start_wall_ms = header.start_wall_ms;
+        return true;
+    }
+
+    // False at the end of the log (a torn last event counts as the end)
+    bool next(UpdateLogEntry &e)
+    {
+        UpdateLogEvent ev;
+        if (!file || fread(&ev, sizeof(ev), 1, file) != 1)
+            return false;
+        std::string payload(ev.length, '\0');
+        if (ev.length && fread(&payload[0], 1, ev.length, file) != ev.length)
+            return false;
+
+        e.t_ms = ev.t_ms;
+        e.widget = ev.widget;
+        e.kind = ev.kind;
+        e.keys.clear();
+        e.values.clear();
+        if (ev.kind == UPDATE_INPUT && payload.size() == sizeof(UpdateLogInput))
+            memcpy(&e.input, payload.data(), sizeof(e.input));
+        else if (ev.kind == UPDATE_DATA)
+        {
+            size_t pos = 0;
+            for (int i = 0; i < ev.count && pos < payload.size(); i++)
+            {
+                std::string key = payload.c_str() + pos;
+                pos += key.size() + 1;
+                if (pos >= payload.size())
+                    break;
+                std::string value = payload.c_str() + pos;
+                pos += value.size() + 1;
+                e.keys.push_back(key);
+                e.values.push_back(value);
+            }
+        }
+        return true;
+    }
+
+private:
+    FILE *file = nullptr;
+};
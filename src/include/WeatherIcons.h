@@ -0,0 +1,164 @@
+#pragma once
+#include <gtk/gtk.h>
+#include <cmath>
+#include <algorithm>
+#include <string>
+#include <string.h>
+#include <ctype.h>
+
+// ----------------- Weather icons -----------------
+// Condition codes and the vector drawings behind them. Drawn with plain
+// cairo paths (no fonts), then kept pre-rasterized in the IconAtlas.
+enum WeatherCondition
+{
+    WEATHER_UNKNOWN = 0,
+    WEATHER_CLEAR,
+    WEATHER_PARTLY_CLOUDY,
+    WEATHER_CLOUDY,
+    WEATHER_RAIN,
+    WEATHER_THUNDER,
+    WEATHER_SNOW,
+    WEATHER_FOG,
+    WEATHER_WIND,
+    WEATHER_CONDITION_COUNT
+};
+
+// Map an icon glyph (e.g. "☀") or a condition text (e.g. "Light rain")
+inline WeatherCondition weather_condition(const std::string &icon, const std::string &cond)
+{
+    static const struct { const char *glyph; WeatherCondition code; } glyphs[] = {
+        {"☀", WEATHER_CLEAR}, {"⛅", WEATHER_PARTLY_CLOUDY}, {"☁", WEATHER_CLOUDY},
+        {"🌧", WEATHER_RAIN}, {"☔", WEATHER_RAIN}, {"⛈", WEATHER_THUNDER},
+        {"❄", WEATHER_SNOW}, {"☃", WEATHER_SNOW}, {"🌫", WEATHER_FOG}, {"🌬", WEATHER_WIND},
+    };
+    for (auto &g : glyphs)
+    {
+        if (icon.compare(0, strlen(g.glyph), g.glyph) == 0 && !icon.empty())
+            return g.code;
+    }
+
+    std::string c;
+    for (char ch : cond)
+        c += static_cast<char>(tolower(static_cast<unsigned char>(ch)));
+
+    // Most specific first: "thunder showers" is thunder, "partly cloudy" partly
+    static const struct { const char *word; WeatherCondition code; } words[] = {
+        {"thunder", WEATHER_THUNDER}, {"storm", WEATHER_THUNDER},
+        {"snow", WEATHER_SNOW}, {"sleet", WEATHER_SNOW},
+        {"rain", WEATHER_RAIN}, {"drizzle", WEATHER_RAIN}, {"shower", WEATHER_RAIN},
+        {"fog", WEATHER_FOG}, {"mist", WEATHER_FOG}, {"haze", WEATHER_FOG},
+        {"partly", WEATHER_PARTLY_CLOUDY},
+        {"cloud", WEATHER_CLOUDY}, {"overcast", WEATHER_CLOUDY},
+        {"wind", WEATHER_WIND},
+        {"clear", WEATHER_CLEAR}, {"sun", WEATHER_CLEAR},
+    };
+    for (auto &w : words)
+    {
+        if (c.find(w.word) != std::string::npos)
+            return w.code;
+    }
+    return WEATHER_UNKNOWN;
+}
+
+// Draw `code` into a size x size box at the origin; opacity is ink
+inline void draw_weather_icon(cairo_t *cr, int code, int size)
+{
+    double s = size;
+    cairo_set_line_cap(cr, CAIRO_LINE_CAP_ROUND);
+    cairo_set_line_width(cr, std::max(1.0, s / 16));
+
+    auto sun = [&](double cx, double cy, double r) {
+        cairo_arc(cr, cx, cy, r, 0, 2 * M_PI);
+        cairo_fill(cr);
+        for (int i = 0; i < 8; i++)
+        {
+            double a = i * M_PI / 4;
+            cairo_move_to(cr, cx + cos(a) * r * 1.45, cy + sin(a) * r * 1.45);
+            cairo_line_to(cr, cx + cos(a) * r * 1.9, cy + sin(a) * r * 1.9);
+        }
+        cairo_stroke(cr);
+    };
+    auto cloud = [&](double y, double alpha) {
+        cairo_set_source_rgba(cr, 0, 0, 0, alpha);
+        cairo_new_sub_path(cr);
+        cairo_arc(cr, s * 0.36, y, s * 0.16, 0, 2 * M_PI);
+        cairo_new_sub_path(cr);
+        cairo_arc(cr, s * 0.56, y - s * 0.08, s * 0.21, 0, 2 * M_PI);
+        cairo_new_sub_path(cr);
+        cairo_arc(cr, s * 0.76, y + s * 0.03, s * 0.13, 0, 2 * M_PI);
+        cairo_rectangle(cr, s * 0.2, y, s * 0.6, s * 0.16);
+        cairo_set_fill_rule(cr, CAIRO_FILL_RULE_WINDING);
+        cairo_fill(cr);
+        cairo_set_source_rgba(cr, 0, 0, 0, 1);
+    };
+
+    cairo_set_source_rgba(cr, 0, 0, 0, 1);
+    switch (code)
+    {
+    case WEATHER_CLEAR:
+        sun(s / 2, s / 2, s * 0.2);
+        break;
+    case WEATHER_PARTLY_CLOUDY:
+        sun(s * 0.36, s * 0.36, s * 0.14);
+        cloud(s * 0.62, 0.6);
+        break;
+    case WEATHER_CLOUDY:
+        cloud(s * 0.5, 0.7);
+        break;
+    case WEATHER_RAIN:
+        cloud(s * 0.38, 0.7);
+        for (int i = 0; i < 3; i++)
+        {
+            double x = s * (0.32 + 0.18 * i);
+            cairo_move_to(cr, x, s * 0.7);
+            cairo_line_to(cr, x - s * 0.06, s * 0.88);
+        }
+        cairo_stroke(cr);
+        break;
+    case WEATHER_THUNDER:
+        cloud(s * 0.34, 0.7);
+        cairo_move_to(cr, s * 0.54, s * 0.52);
+        cairo_line_to(cr, s * 0.4, s * 0.74);
+        cairo_line_to(cr, s * 0.52, s * 0.74);
+        cairo_line_to(cr, s * 0.44, s * 0.95);
+        cairo_line_to(cr, s * 0.66, s * 0.66);
+        cairo_line_to(cr, s * 0.54, s * 0.66);
+        cairo_close_path(cr);
+        cairo_fill(cr);
+        break;
+    case WEATHER_SNOW:
+        for (int i = 0; i < 3; i++)
+        {
+            double a = i * M_PI / 3;
+            cairo_move_to(cr, s / 2 - cos(a) * s * 0.36, s / 2 - sin(a) * s * 0.36);
+            cairo_line_to(cr, s / 2 + cos(a) * s * 0.36, s / 2 + sin(a) * s * 0.36);
+        }
+        cairo_stroke(cr);
+        break;
+    case WEATHER_FOG:
+        for (int i = 0; i < 4; i++)
+        {
+            double y = s * (0.3 + 0.14 * i);
+            cairo_move_to(cr, s * (0.18 + 0.06 * (i % 2)), y);
+            cairo_line_to(cr, s * (0.82 - 0.06 * (i % 2)), y);
+        }
+        cairo_stroke(cr);
+        break;
+    case WEATHER_WIND:
+        for (int i = 0; i < 3; i++)
+        {
+            double y = s * (0.32 + 0.18 * i);
+            double end = s * (0.62 + 0.1 * (i % 2));
+            cairo_move_to(cr, s * 0.14, y);
+            cairo_line_to(cr, end, y);
+            cairo_arc_negative(cr, end, y - s * 0.07, s * 0.07, M_PI / 2, -M_PI);
+        }
+        cairo_stroke(cr);
+        break;
+    default:
+        // Unknown: a hollow circle
+        cairo_arc(cr, s / 2, s / 2, s * 0.3, 0, 2 * M_PI);
+        cairo_stroke(cr);
+        break;
+    }
+}
@@ -1,12 +1,18 @@
 #pragma once
 #include <gtk/gtk.h>
 #include <string>
+#include <string.h>
+#include <stdlib.h>
 #include "ModularWidget.h"
+#include "TextStyle.h"
+#include "IconAtlas.h"
+#include "WeatherIcons.h"
+#include "DataDir.h"
 
 class WeatherWidget : public ModularWidget
 {
 public:
-    GtkWidget *icon_label;
+    GtkWidget *icon_area; // icon blitted from the atlas, no font involved
     GtkWidget *temp_label;
     GtkWidget *cond_label;
 
@@ -19,39 +25,164 @@ public:
         gtkWidget = gtk_vbox_new(FALSE, 5);
 
         // Weather icon (big)
-        icon_label = gtk_label_new(NULL);
-        std::string icon_markup = "<span size='24000'>" + icon + "</span>";
-        gtk_label_set_markup(GTK_LABEL(icon_label), icon_markup.c_str());
-        gtk_box_pack_start(GTK_BOX(gtkWidget), icon_label, FALSE, FALSE, 0);
+        icon_area = gtk_drawing_area_new();
+        gtk_widget_set_size_request(icon_area, -1, ICON_HEIGHT);
+        g_signal_connect(G_OBJECT(icon_area), "expose-event",
+                         G_CALLBACK(on_icon_expose_static), this);
+        gtk_box_pack_start(GTK_BOX(gtkWidget), icon_area, FALSE, FALSE, 0);
 
         // Temperature (bold, large)
         temp_label = gtk_label_new(NULL);
-        std::string temp_markup = "<span size='20000' weight='bold'>" + std::to_string(temp) + "°C</span>";
-        gtk_label_set_markup(GTK_LABEL(temp_label), temp_markup.c_str());
+        temp_style().apply(temp_label);
         gtk_box_pack_start(GTK_BOX(gtkWidget), temp_label, FALSE, FALSE, 0);
 
         // Condition (italic, smaller)
         cond_label = gtk_label_new(NULL);
-        std::string cond_markup = "<span size='14000' style='italic'>" + cond + "</span>";
-        gtk_label_set_markup(GTK_LABEL(cond_label), cond_markup.c_str());
+        cond_style().apply(cond_label);
         gtk_box_pack_start(GTK_BOX(gtkWidget), cond_label, FALSE, FALSE, 0);
 
+        update_weather(icon, temp, cond);
+
         gtk_widget_show_all(gtkWidget);
         initialize();
     }
 
     GtkWidget *get_widget() { return gtkWidget; }
 
+    const char *type_name() const override { return "WeatherWidget"; }
+
+    uint64_t state_hash() const override
+    {
+        uint64_t h = hash_bytes(&condition, sizeof(condition));
+        for (GtkWidget *label : {temp_label, cond_label})
+        {
+            const char *shown = gtk_label_get_text(GTK_LABEL(label));
+            h = hash_bytes(shown, strlen(shown) + 1, h);
+        }
+        return h;
+    }
+
+    size_t save_state(uint8_t *out, size_t max) const override
+    {
+        WeatherState state;
+        memset(&state, 0, sizeof(state));
+        state.temp = temperature;
+        strncpy(state.icon, icon_text.c_str(), sizeof(state.icon) - 1);
+        strncpy(state.cond, gtk_label_get_text(GTK_LABEL(cond_label)), sizeof(state.cond) - 1);
+        memcpy(out, &state, sizeof(state));
+        return sizeof(state);
+    }
+
+    void restore_state(const uint8_t *in, size_t len) override
+    {
+        WeatherState state;
+        if (len != sizeof(state))
+            return;
+        memcpy(&state, in, sizeof(state));
+        state.icon[sizeof(state.icon) - 1] = 0;
+        state.cond[sizeof(state.cond) - 1] = 0;
+        update_weather(state.icon, state.temp, state.cond);
+    }
+
+    // Data file fields: icon, temperature, condition
+    void on_data(const char *const *keys, const char *const *values, int count) override
+    {
+        std::string icon = icon_text;
+        int temp = temperature;
+        std::string cond = gtk_label_get_text(GTK_LABEL(cond_label));
+        bool known = false;
+        for (int i = 0; i < count; i++)
+        {
+            if (strcmp(keys[i], "icon") == 0)
+                icon = values[i];
+            else if (strcmp(keys[i], "temperature") == 0)
+                temp = atoi(values[i]);
+            else if (strcmp(keys[i], "condition") == 0)
+                cond = values[i];
+            else
+                continue;
+            known = true;
+        }
+        if (known)
+            update_weather(icon, temp, cond);
+    }
+
     // Update values later (e.g. from API or manual input)
     void update_weather(const std::string &icon, int temp, const std::string &cond)
     {
-        std::string icon_markup = "<span size='24000'>" + icon + "</span>";
-        gtk_label_set_markup(GTK_LABEL(icon_label), icon_markup.c_str());
+        int code = weather_condition(icon, cond);
+        if (code != condition)
+        {
+            condition = code;
+            queue_redraw(REFRESH_TIME_CRITICAL, icon_area);
+        }
+        icon_text = icon;
 
-        std::string temp_markup = "<span size='20000' weight='bold'>" + std::to_string(temp) + "°C</span>";
-        gtk_label_set_markup(GTK_LABEL(temp_label), temp_markup.c_str());
+        char temp_text[16];
+        snprintf(temp_text, sizeof(temp_text), "%d°C", temp);
+        set_label_text(temp_label, temp_text);
 
-        std::string cond_markup = "<span size='14000' style='italic'>" + cond + "</span>";
-        gtk_label_set_markup(GTK_LABEL(cond_label), cond_markup.c_str());
+        set_label_text(cond_label, cond.c_str());
+
+        temperature = temp;
+        persist_state();
+    }
+
+private:
+    static constexpr int ICON_HEIGHT = 40;
+    int temperature = 0;
+    int condition = -1;    // WeatherCondition shown
+    std::string icon_text; // as passed in, kept for persistence
+
+    struct WeatherState
+    {
+        int32_t temp;
+        char icon[16];
+        char cond[64];
+    };
+
+    static IconAtlas &icon_atlas()
+    {
+        static IconAtlas atlas(data_path("weather-icons.atlas"), draw_weather_icon,
+                               WEATHER_CONDITION_COUNT);
+        return atlas;
+    }
+
+    static gboolean on_icon_expose_static(GtkWidget *widget, GdkEventExpose *event, gpointer data)
+    {
+        auto *self = static_cast<WeatherWidget *>(data);
+
+        // Snap to a few sizes so the atlas stays small
+        static const int sizes[] = {128, 96, 64, 48, 40, 32, 24, 16};
+        int avail = std::min(widget->allocation.width, widget->allocation.height);
+        int size = sizes[sizeof(sizes) / sizeof(sizes[0]) - 1];
+        for (int s : sizes)
+        {
+            if (s <= avail)
+            {
+                size = s;
+                break;
+            }
+        }
+
+        cairo_t *cr = gdk_cairo_create(widget->window);
+        cairo_set_source_rgb(cr, 0, 0, 0);
+        icon_atlas().paint(cr, self->condition, size,
+                           (widget->allocation.width - size) / 2,
+                           (widget->allocation.height - size) / 2);
+        cairo_destroy(cr);
+        return FALSE;
+    }
+
+    // Shared by every WeatherWidget; built on first use
+    static const TextStyle &temp_style()
+    {
+        static const TextStyle style(20000, PANGO_WEIGHT_BOLD);
+        return style;
+    }
+    static const TextStyle &cond_style()
+    {
+        static const TextStyle style(14000, PANGO_WEIGHT_NORMAL, PANGO_STYLE_ITALIC);
+        return style;
     }
 };
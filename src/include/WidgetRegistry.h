@@ -0,0 +1,202 @@
+#pragma once
+#include <gtk/gtk.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <dlfcn.h>
+#include <map>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+#include "ModularWidget.h"
+#include "DataSource.h"
+#include "BinLog.h"
+
+// ----------------- Widget plugins -----------------
+// Widgets are created by type name through WidgetRegistry. Built-in types
+// register at startup (BuiltinWidgets.h); any other name is looked up as
+// <plugin dir>/<TypeName>.so the first time a layout asks for it, so only
+// widgets actually on screen cost code, relocations and static init.
+//
+// Plugin ABI (bump WIDGET_PLUGIN_ABI on any change to ModularWidget's layout
+// or to the structs below):
+//  - the module exports DWK_PLUGIN_INIT, which registers its factories
+//  - everything crossing the boundary is plain C data: no std:: types,
+//    since host and plugin each carry a -static-libstdc++ copy. Host
+//    services that call back into plugin code (e.g. WorkerPool) take a
+//    function pointer and a context pointer instead of closures.
+//  - the host is linked with export_dynamic, so inline statics shared by
+//    both sides (Clock::get, Trace, ModularWidget::instances, operator new)
+//    resolve to the host's single copy
+//  - plugins are never unloaded: widget vtables live in them
+
+#define WIDGET_PLUGIN_ABI 4
+
+#ifndef DWK_PLUGIN_DIR
+#define DWK_PLUGIN_DIR "plugins"
+#endif
+
+// Position plus string key/value parameters for a factory
+struct WidgetParams
+{
+    int col, row;
+    int width_blocks, height_blocks;
+    int count;
+    const char *const *keys;
+    const char *const *values;
+
+    const char *get(const char *key, const char *fallback = nullptr) const
+    {
+        for (int i = 0; i < count; i++)
+        {
+            if (strcmp(keys[i], key) == 0)
+                return values[i];
+        }
+        return fallback;
+    }
+
+    int get_int(const char *key, int fallback) const
+    {
+        const char *v = get(key);
+        return v ? atoi(v) : fallback;
+    }
+
+    bool get_bool(const char *key, bool fallback) const
+    {
+        const char *v = get(key);
+        if (!v)
+            return fallback;
+        return strcmp(v, "1") == 0 || strcmp(v, "true") == 0 || strcmp(v, "yes") == 0;
+    }
+};
+
+typedef ModularWidget *(*WidgetFactory)(const WidgetParams *params);
+
+struct WidgetPluginHost
+{
+    int abi_version;
+    void (*register_widget)(const char *name, WidgetFactory factory);
+};
+
+// Entry point every plugin defines; return 0 to refuse loading
+#define DWK_PLUGIN_INIT \
+    extern "C" __attribute__((visibility("default"))) int dwk_plugin_init(const WidgetPluginHost *host)
+
+typedef int (*WidgetPluginInit)(const WidgetPluginHost *host);
+
+class WidgetRegistry
+{
+public:
+    std::string plugin_dir;
+
+    static WidgetRegistry &get()
+    {
+        static WidgetRegistry registry;
+        return registry;
+    }
+
+    void add(const char *name, WidgetFactory factory)
+    {
+        factories[name] = factory;
+    }
+
+    // Factory for `name`, loading its plugin on first use; null if unknown
+    WidgetFactory find(const std::string &name)
+    {
+        auto it = factories.find(name);
+        if (it == factories.end() && load_plugin(name))
+            it = factories.find(name);
+        return it == factories.end() ? nullptr : it->second;
+    }
+
+    ModularWidget *create(const std::string &name, const WidgetParams &params)
+    {
+        WidgetFactory factory = find(name);
+        if (!factory)
+        {
+            BINLOG("[PLUGIN] unknown widget type %s", name.c_str());
+            return nullptr;
+        }
+        ModularWidget *widget = factory(&params);
+        // Generic parameters: source=<file> [source_field=<key>]
+        if (const char *source = params.get("source"))
+            DataSources::get().bind(source, params.get("source_field", ""), widget);
+        // max_defer=<seconds>: longest wait of a background redraw
+        if (widget && params.get("max_defer"))
+            widget->max_defer_ms = static_cast<guint>(std::max(0, params.get_int("max_defer", 60))) * 1000;
+        // ghost_threshold=<score>|off: when this tile gets its own flash
+        if (const char *ghost = params.get("ghost_threshold"))
+        {
+            if (widget)
+                widget->ghost.threshold = strcmp(ghost, "off") == 0 ? -1.0f : static_cast<float>(atof(ghost));
+        }
+        return widget;
+    }
+
+    size_t loaded_plugins() const { return handles.size(); }
+
+private:
+    std::map<std::string, WidgetFactory> factories;
+    std::set<std::string> attempted; // each plugin file is tried once
+    std::vector<void *> handles;
+
+    WidgetRegistry()
+    {
+        const char *env = g_getenv("DWK_PLUGIN_DIR");
+        plugin_dir = env && *env ? env : DWK_PLUGIN_DIR;
+    }
+
+    bool load_plugin(const std::string &name)
+    {
+        if (!attempted.insert(name).second)
+            return false;
+
+        std::string path = plugin_dir + "/" + name + ".so";
+        void *handle = dlopen(path.c_str(), RTLD_NOW | RTLD_LOCAL);
+        if (!handle)
+        {
+            BINLOG("[PLUGIN] %s", dlerror());
+            return false;
+        }
+
+        auto init = reinterpret_cast<WidgetPluginInit>(dlsym(handle, "dwk_plugin_init"));
+        static const WidgetPluginHost host{WIDGET_PLUGIN_ABI, host_register};
+        if (!init || !init(&host))
+        {
+            BINLOG("[PLUGIN] %s: no usable dwk_plugin_init", path.c_str());
+            dlclose(handle);
+            return false;
+        }
+
+        handles.push_back(handle);
+        return true;
+    }
+
+    static void host_register(const char *name, WidgetFactory factory)
+    {
+        get().add(name, factory);
+    }
+};
+
+// One widget of a layout: type name, grid placement and parameters
+struct WidgetSpec
+{
+    std::string type;
+    int col, row;
+    int width_blocks, height_blocks;
+    std::vector<std::pair<std::string, std::string>> params;
+
+    ModularWidget *create() const
+    {
+        std::vector<const char *> keys, values;
+        for (auto &p : params)
+        {
+            keys.push_back(p.first.c_str());
+            values.push_back(p.second.c_str());
+        }
+        WidgetParams wp{col, row, width_blocks, height_blocks, static_cast<int>(params.size()),
+                        keys.data(), values.data()};
+        return WidgetRegistry::get().create(type, wp);
+    }
+};
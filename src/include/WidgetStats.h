@@ -0,0 +1,13 @@
+#pragma once
+#include <stdint.h>
+
+// Per-widget cost counters, always on. Every field is a plain increment on
+// paths that already do far more work (expose, timer dispatch, label update).
+struct WidgetStats
+{
+    uint32_t expose_calls = 0;
+    uint64_t render_us = 0;         // time spent inside expose handlers
+    uint64_t invalidated_bytes = 0; // exposed area at the panel's 8-bit depth
+    uint32_t wakeups = 0;           // timer callbacks dispatched for the widget
+    uint32_t label_updates = 0;     // label texts that actually changed
+};
@@ -0,0 +1,228 @@
+#pragma once
+#include <gtk/gtk.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <errno.h>
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <sys/eventfd.h>
+#include "BinLog.h"
+
+// Half of a WorkerPool job, called with the job's context
+typedef void (*WorkerFunc)(gpointer data);
+
+// ----------------- WorkerPool -----------------
+// A few threads for work that must not block the main loop (parsing,
+// decoding). A job runs `work(data)` on a worker, then `done(data)` on the
+// main thread, where touching GTK is safe again; `data` carries the inputs
+// and the result between the two. Plugins submit jobs too, so a job is
+// plain C: two function pointers and a context (see WidgetRegistry.h).
+//
+// Finished jobs queue up and one eventfd wakeup (watched from the main
+// loop) delivers the whole batch in a single dispatch. The firmware's GLib
+// predates always-on threading, so workers never call into GLib
+// themselves.
+//
+// Every job has an owner; cancel(owner) drops its queued jobs and any
+// result not delivered yet (ModularWidget does this on destruction).
+// `destroy` frees `data` once the job is delivered or dropped; for a job
+// cancelled while it runs, that happens on the worker thread.
+class WorkerPool
+{
+public:
+    static constexpr int THREADS = 2;
+
+    // Never destroyed: workers may still wait on the queue at exit
+    static WorkerPool &get()
+    {
+        static WorkerPool *pool = new WorkerPool;
+        return *pool;
+    }
+
+    // Cancel without creating the pool when it was never used
+    static void cancel_all(const void *owner)
+    {
+        if (started())
+            get().cancel(owner);
+    }
+
+    void submit(const void *owner, WorkerFunc work, WorkerFunc done, gpointer data, GDestroyNotify destroy)
+    {
+        push(new Job{owner, work, done, data, destroy});
+    }
+
+    void cancel(const void *owner)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto drop = [owner](std::deque<Job *> &q) {
+            for (auto it = q.begin(); it != q.end();)
+            {
+                if ((*it)->owner == owner)
+                {
+                    delete *it;
+                    it = q.erase(it);
+                }
+                else
+                    ++it;
+            }
+        };
+        drop(queued);
+        drop(finished);
+        drop(delivering); // a done callback cancelling later results
+        for (Job *job : running)
+        {
+            if (job->owner == owner)
+                job->cancelled = true;
+        }
+    }
+
+    // Jobs and delivered batches so far (for reports)
+    uint64_t jobs_done = 0;
+    uint64_t batches = 0;
+
+private:
+    struct Job
+    {
+        const void *owner;
+        WorkerFunc work; // worker thread
+        WorkerFunc done; // main thread
+        gpointer data;
+        GDestroyNotify destroy;
+        bool cancelled = false;
+
+        void run() { work(data); }
+        void deliver() { done(data); }
+
+        ~Job()
+        {
+            if (destroy)
+                destroy(data);
+        }
+    };
+
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::deque<Job *> queued, finished;
+    std::deque<Job *> delivering; // main thread only
+    std::vector<Job *> running;
+    std::vector<std::thread> threads;
+    int event_fd = -1;
+    guint watch_id = 0;
+
+    static bool &started()
+    {
+        static bool flag = false;
+        return flag;
+    }
+
+    WorkerPool()
+    {
+        started() = true;
+        event_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (event_fd < 0)
+        {
+            BINLOG("[WORKER] eventfd failed, errno %d", errno);
+            return;
+        }
+        GIOChannel *ch = g_io_channel_unix_new(event_fd);
+        watch_id = g_io_add_watch(ch, G_IO_IN, on_ready_static, this);
+        g_io_channel_unref(ch);
+
+        for (int i = 0; i < THREADS; i++)
+        {
+            threads.emplace_back(&WorkerPool::worker, this);
+            threads.back().detach();
+        }
+    }
+
+    WorkerPool(const WorkerPool &) = delete;
+    WorkerPool &operator=(const WorkerPool &) = delete;
+
+    void push(Job *job)
+    {
+        if (threads.empty())
+        {
+            // No pool (eventfd failed): do it inline, results stay ordered
+            job->run();
+            job->deliver();
+            delete job;
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            queued.push_back(job);
+        }
+        wake.notify_one();
+    }
+
+    void worker()
+    {
+        for (;;)
+        {
+            Job *job;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                wake.wait(lock, [this] { return !queued.empty(); });
+                job = queued.front();
+                queued.pop_front();
+                running.push_back(job);
+            }
+
+            job->run();
+
+            bool first;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                running.erase(std::find(running.begin(), running.end(), job));
+                if (job->cancelled)
+                {
+                    delete job;
+                    continue;
+                }
+                first = finished.empty();
+                finished.push_back(job);
+            }
+            // Only the first result of a batch needs to wake the main loop
+            if (first)
+            {
+                uint64_t one = 1;
+                ssize_t n = write(event_fd, &one, sizeof(one));
+                (void)n;
+            }
+        }
+    }
+
+    static gboolean on_ready_static(GIOChannel *source, GIOCondition condition, gpointer data)
+    {
+        static_cast<WorkerPool *>(data)->deliver_batch();
+        return TRUE;
+    }
+
+    void deliver_batch()
+    {
+        uint64_t count;
+        ssize_t n = read(event_fd, &count, sizeof(count));
+        (void)n;
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            delivering.swap(finished);
+        }
+        if (delivering.empty())
+            return;
+        batches++;
+        while (!delivering.empty())
+        {
+            Job *job = delivering.front();
+            delivering.pop_front();
+            jobs_done++;
+            job->deliver();
+            delete job;
+        }
+    }
+};
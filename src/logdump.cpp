@@ -0,0 +1,174 @@
+// Turns a BinLog file (BinLog.h) back into text, one line per entry:
+//   2026-10-19 14:03:07.123456 [tid] message
+//
+// Usage: dynamic-widget-logdump <log> [more logs, e.g. <log>.old first]
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <map>
+#include <string>
+#include "BinLog.h"
+
+// printf one conversion with the entry's next argument. `spec` is the
+// conversion without length modifiers; integers are widened to long long.
+static void format_arg(std::string &out, std::string spec, char conv,
+                       const BinLogEntry &e, int index, size_t &pos)
+{
+    char buf[320];
+    int type = index < e.nargs ? (e.types >> (2 * index)) & 3 : -1;
+    if (type == BINLOG_STRING)
+    {
+        size_t len = e.args[pos];
+        std::string s(reinterpret_cast<const char *>(e.args + pos + 1), len);
+        pos += 1 + len;
+        snprintf(buf, sizeof(buf), (spec + "s").c_str(), s.c_str());
+    }
+    else if (type == BINLOG_DOUBLE)
+    {
+        double d;
+        memcpy(&d, e.args + pos, sizeof(d));
+        pos += sizeof(d);
+        if (strchr("eEfFgGaA", conv))
+            snprintf(buf, sizeof(buf), (spec + conv).c_str(), d);
+        else
+            snprintf(buf, sizeof(buf), "%g", d);
+    }
+    else if (type == BINLOG_INT)
+    {
+        long long i;
+        int64_t v;
+        memcpy(&v, e.args + pos, sizeof(v));
+        pos += sizeof(v);
+        i = v;
+        if (conv == 'c')
+            snprintf(buf, sizeof(buf), (spec + "c").c_str(), static_cast<int>(i));
+        else if (strchr("diuxXo", conv))
+            snprintf(buf, sizeof(buf), (spec + "ll" + conv).c_str(), i);
+        else
+            snprintf(buf, sizeof(buf), "%lld", i);
+    }
+    else
+        snprintf(buf, sizeof(buf), "<missing>");
+    out += buf;
+}
+
+static std::string format_entry(const std::string &fmt, const BinLogEntry &e)
+{
+    std::string out;
+    size_t pos = 0;
+    int index = 0;
+    for (size_t i = 0; i < fmt.size(); i++)
+    {
+        if (fmt[i] != '%')
+        {
+            out += fmt[i];
+            continue;
+        }
+        if (i + 1 < fmt.size() && fmt[i + 1] == '%')
+        {
+            out += '%';
+            i++;
+            continue;
+        }
+        // %[flags][width][.precision][length]conversion
+        std::string spec = "%";
+        size_t j = i + 1;
+        while (j < fmt.size() && strchr("-+ #0123456789.", fmt[j]))
+            spec += fmt[j++];
+        while (j < fmt.size() && strchr("hlLqjzt", fmt[j]))
+            j++;
+        if (j >= fmt.size())
+            break;
+        format_arg(out, spec, fmt[j], e, index++, pos);
+        i = j;
+    }
+    while (!out.empty() && out.back() == '\n')
+        out.pop_back();
+    return out;
+}
+
+static void print_time(int64_t wall_us)
+{
+    time_t secs = static_cast<time_t>(wall_us / 1000000);
+    struct tm t;
+    localtime_r(&secs, &t);
+    char when[32];
+    strftime(when, sizeof(when), "%Y-%m-%d %H:%M:%S", &t);
+    printf("%s.%06lld", when, static_cast<long long>(wall_us % 1000000));
+}
+
+static bool dump(const char *path)
+{
+    FILE *f = fopen(path, "rb");
+    if (!f)
+    {
+        perror(path);
+        return false;
+    }
+
+    std::map<uint16_t, std::string> formats;
+    int tag;
+    while ((tag = fgetc(f)) != EOF)
+    {
+        if (tag == BINLOG_SESSION)
+        {
+            BinLogSession s;
+            if (fread(&s, sizeof(s), 1, f) != 1 || s.magic != BinLog::MAGIC || s.version != BinLog::VERSION)
+                break;
+            formats.clear(); // ids restart with every run
+            print_time(s.wall_us);
+            printf(" ---- session, pid %u\n", s.pid);
+        }
+        else if (tag == BINLOG_FORMAT)
+        {
+            BinLogFormat h;
+            if (fread(&h, sizeof(h), 1, f) != 1)
+                break;
+            std::string text(h.length, '\0');
+            if (h.length && fread(&text[0], 1, h.length, f) != h.length)
+                break;
+            formats[h.id] = text;
+        }
+        else if (tag == BINLOG_EVENT)
+        {
+            BinLogEntry e;
+            if (fread(&e, sizeof(e), 1, f) != 1)
+                break;
+            auto it = formats.find(e.format);
+            print_time(e.wall_us);
+            printf(" [%u] %s\n", e.thread,
+                   it == formats.end() ? "<unknown format>" : format_entry(it->second, e).c_str());
+        }
+        else if (tag == BINLOG_DROPPED)
+        {
+            BinLogDropped d;
+            if (fread(&d, sizeof(d), 1, f) != 1)
+                break;
+            printf("                           [%u] ... %u entries dropped (ring full)\n", d.thread, d.count);
+        }
+        else
+        {
+            fprintf(stderr, "%s: corrupt record at offset %ld\n", path, ftell(f) - 1);
+            break; // a torn write from a crash ends the file
+        }
+    }
+    fclose(f);
+    return true;
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc < 2)
+    {
+        fprintf(stderr, "usage: %s <log> [log...]\n", argv[0]);
+        return 2;
+    }
+    int status = 0;
+    for (int i = 1; i < argc; i++)
+    {
+        if (!dump(argv[i]))
+            status = 1;
+    }
+    return status;
+}
@@ -3,15 +3,17 @@
 #include <vector>
 #include <algorithm>
 #include <cmath>
-#include "WeatherWidget.h"
 #include "KindleWindow.h"
-#include "TimeAndDateWidget.h"
 #include "ModularWidget.h"
-#include "QuoteWidget.h"
-#include "SpeakerGrill.h"
-#include "SpeakerGrillCounter.h"
-#include "SpeakerGrillDice.h"
-#include "BatteryWidget.h"
+#include "Dashboard.h"
+#include "BuiltinWidgets.h"
+#include "StatsServer.h"
+#include "FrameSnapshot.h"
+#include "DataDir.h"
+#include "ResumeMonitor.h"
+#include "PowerState.h"
+#include "BinLog.h"
+#include <errno.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -26,7 +28,7 @@
 
 int device_discovery() {
     int sock = socket(AF_INET, SOCK_DGRAM, 0);
-    if (sock < 0) { perror("socket"); return 1; }
+    if (sock < 0) { BINLOG("[DISCOVERY] socket failed, errno %d", errno); return 1; }
 
     // Enable broadcast
     int broadcastEnable = 1;
@@ -37,7 +39,7 @@ int device_discovery() {
     memset(&ifr, 0, sizeof(ifr));
     strncpy(ifr.ifr_name, "eth0", IFNAMSIZ-1);
     if (setsockopt(sock, SOL_SOCKET, SO_BINDTODEVICE, &ifr, sizeof(ifr)) < 0) {
-        perror("bind to device failed");
+        BINLOG("[DISCOVERY] bind to device failed, errno %d", errno);
         // Not fatal, continue
     }
 
@@ -56,25 +58,25 @@ int device_discovery() {
 
     // Send discovery message
     char *msg = "DISCOVER_SERVER";
-    printf("[INFO] Sending broadcast message: %s\n", msg);
+    BINLOG("[DISCOVERY] sending broadcast message: %s", msg);
     int n = sendto(sock, msg, strlen(msg), 0,
                    (struct sockaddr*)&broadcastAddr, sizeof(broadcastAddr));
     if (n < 0) {
-        perror("[ERROR] Failed to send broadcast");
+        BINLOG("[DISCOVERY] failed to send broadcast, errno %d", errno);
         close(sock);
         return 1;
     }
 
-    printf("[INFO] Waiting for server reply...\n");
+    BINLOG("[DISCOVERY] waiting for server reply");
     char buffer[BUFFER_SIZE];
     struct sockaddr_in fromAddr;
     socklen_t addrLen = sizeof(fromAddr);
     n = recvfrom(sock, buffer, BUFFER_SIZE-1, 0, (struct sockaddr*)&fromAddr, &addrLen);
     if (n > 0) {
         buffer[n] = 0;
-        printf("[INFO] Discovered server at %s\n", buffer);
+        BINLOG("[DISCOVERY] discovered server at %s", buffer);
     } else {
-        perror("[ERROR] No reply received");
+        BINLOG("[DISCOVERY] no reply received, errno %d", errno);
     }
 
     close(sock);
@@ -89,48 +91,59 @@ int main(int argc, char *argv[])
 {
     // device_discovery();
     // return 0;
+
+    // Put the last frame on the panel before GTK and fonts load
+    std::string snapshot_path = data_path("last-frame.bin");
+    FrameSnapshot::show_on_panel(snapshot_path);
+
     gtk_init(&argc, &argv);
+    Trace::install_signal_handler(); // kill -USR1 <pid> dumps the trace
+    BinLog::open(data_path("dynamic-widget.binlog")); // dynamic-widget-logdump reads it
+
+    // DWK_RECORD=<file>: log taps and pushed data for dynamic-widget-replay
+    if (const char *record = g_getenv("DWK_RECORD"))
+        UpdateRecorder::get().open(record);
 
     KindleWindow kw(height, width);
     kw.set_grid_overlay(true);
+    kw.enable_snapshot(snapshot_path);
+
+    // Widgets restore their last state from here when added to the window
+    StateStore state_store(data_path("widget-state.bin"));
+    ModularWidget::state_store() = &state_store;
 
     // GtkWidget *button2 = gtk_button_new_with_label("Button 2");
     // kw.add_widget_at_grid(button2, 2,2,2,2);
-    SpeakerGrill *grill = new SpeakerGrill(1, 1, 4, 1, 16);
-    kw.add_widget_at_grid(grill);
-
-    TimeDateWidget *td_widget = new TimeDateWidget(1, 2, 2, 1, 1, false);
-    kw.add_widget_at_grid(td_widget);
-
-    WeatherWidget *weather = new WeatherWidget(3, 2, 2, 1);
-    kw.add_widget_at_grid(weather);
-
-    weather->update_weather("", 19, "Rainy");
-
-    SpeakerGrill *grill2 = new SpeakerGrill(1, 3, 1, 1, 16);
-    kw.add_widget_at_grid(grill2);
-
-    SpeakerGrillCounter *grillCounter = new SpeakerGrillCounter(2, 3, 1, 1, 16);
-    kw.add_widget_at_grid(grillCounter);
-
-    SpeakerGrillDice *grillDice = new SpeakerGrillDice(3, 3);
-    kw.add_widget_at_grid(grillDice);
-
-
-    QuoteWidget *quote = new QuoteWidget( 1, 4, 4, 1, "Two things are infinite: the universe and human stupidity; and I'm not sure about the universe.");
-    kw.add_widget_at_grid(quote);
-
-        // Add Battery Widget at Column 4, Row 1 (Top Right corner)
-    BatteryWidget *battery = new BatteryWidget(4, 3, 1, 1);
-
-    // Optional: If testing on PC (no battery file), simulate a value:
-    // battery->set_values(85, true); 
-
-    kw.add_widget_at_grid(battery);
 
+    // Widgets are built from the main loop once the window (showing the
+    // snapshot) is up
+    // Layout: first argument, else <data dir>/layout.txt, else built-in
+    register_builtin_widgets();
+    std::string layout_path = argc > 1 ? argv[1] : data_path("layout.txt");
+    if (!g_file_test(layout_path.c_str(), G_FILE_TEST_EXISTS) || !kw.load_layout(layout_path))
+        build_dashboard(kw);
 
     kw.show_all();
 
+    // Per-widget render/wakeup counters over a UNIX socket + binary log
+    StatsServer stats;
+
+    // Wake from suspend: one catch-up pass and one refresh for all widgets
+    ResumeMonitor resume([&kw]() { kw.catch_up_after_resume(); });
+
+    // Screensaver / screen off: freeze all widget timers until visible again
+    PowerState power(PowerState::default_source(),
+                     [&kw, &resume]()
+                     {
+                         resume.set_enabled(false);
+                         kw.display_off();
+                     },
+                     [&kw, &resume]()
+                     {
+                         resume.set_enabled(true);
+                         kw.display_on();
+                     });
+
 
 
 
@@ -0,0 +1,18 @@
+// Agenda from an .ics file as a loadable plugin (AgendaWidget.so)
+#include "WidgetRegistry.h"
+#include "AgendaWidget.h"
+
+static ModularWidget *create(const WidgetParams *p)
+{
+    const char *ics = p->get("ics");
+    return new AgendaWidget(p->col, p->row, p->width_blocks, p->height_blocks,
+                            ics ? ics : data_path("calendar.ics"), p->get_int("count", 5));
+}
+
+DWK_PLUGIN_INIT
+{
+    if (host->abi_version != WIDGET_PLUGIN_ABI)
+        return 0;
+    host->register_widget("AgendaWidget", create);
+    return 1;
+}
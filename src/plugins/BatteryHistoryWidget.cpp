@@ -0,0 +1,17 @@
+// Battery history graph as a loadable plugin (BatteryHistoryWidget.so)
+#include "WidgetRegistry.h"
+#include "BatteryHistoryWidget.h"
+
+static ModularWidget *create(const WidgetParams *p)
+{
+    return new BatteryHistoryWidget(p->col, p->row, p->width_blocks, p->height_blocks,
+                                    p->get_int("days", 7));
+}
+
+DWK_PLUGIN_INIT
+{
+    if (host->abi_version != WIDGET_PLUGIN_ABI)
+        return 0;
+    host->register_widget("BatteryHistoryWidget", create);
+    return 1;
+}
@@ -0,0 +1,18 @@
+// Photo frame as a loadable plugin (PhotoFrameWidget.so)
+#include "WidgetRegistry.h"
+#include "PhotoFrameWidget.h"
+
+static ModularWidget *create(const WidgetParams *p)
+{
+    const char *dir = p->get("dir");
+    return new PhotoFrameWidget(p->col, p->row, p->width_blocks, p->height_blocks,
+                                dir ? dir : data_path("photos"), p->get_int("interval", 300));
+}
+
+DWK_PLUGIN_INIT
+{
+    if (host->abi_version != WIDGET_PLUGIN_ABI)
+        return 0;
+    host->register_widget("PhotoFrameWidget", create);
+    return 1;
+}
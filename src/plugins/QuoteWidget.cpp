@@ -0,0 +1,17 @@
+// Quote widget as a loadable plugin (QuoteWidget.so)
+#include "WidgetRegistry.h"
+#include "QuoteWidget.h"
+
+static ModularWidget *create(const WidgetParams *p)
+{
+    return new QuoteWidget(p->col, p->row, p->width_blocks, p->height_blocks,
+                           p->get("text", "Stay hungry, stay foolish."));
+}
+
+DWK_PLUGIN_INIT
+{
+    if (host->abi_version != WIDGET_PLUGIN_ABI)
+        return 0;
+    host->register_widget("QuoteWidget", create);
+    return 1;
+}
@@ -0,0 +1,17 @@
+// Dice widget as a loadable plugin (SpeakerGrillDice.so)
+#include "WidgetRegistry.h"
+#include "SpeakerGrillDice.h"
+
+static ModularWidget *create(const WidgetParams *p)
+{
+    return new SpeakerGrillDice(p->col, p->row, p->width_blocks, p->height_blocks,
+                                p->get_int("radius", 22));
+}
+
+DWK_PLUGIN_INIT
+{
+    if (host->abi_version != WIDGET_PLUGIN_ABI)
+        return 0;
+    host->register_widget("SpeakerGrillDice", create);
+    return 1;
+}
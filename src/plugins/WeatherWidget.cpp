@@ -0,0 +1,18 @@
+// Weather widget as a loadable plugin (WeatherWidget.so)
+#include "WidgetRegistry.h"
+#include "WeatherWidget.h"
+
+static ModularWidget *create(const WidgetParams *p)
+{
+    return new WeatherWidget(p->col, p->row, p->width_blocks, p->height_blocks,
+                             p->get("icon", "☀"), p->get_int("temperature", 25),
+                             p->get("condition", "Sunny"));
+}
+
+DWK_PLUGIN_INIT
+{
+    if (host->abi_version != WIDGET_PLUGIN_ABI)
+        return 0;
+    host->register_widget("WeatherWidget", create);
+    return 1;
+}
@@ -0,0 +1,208 @@
+// Replays an UpdateLog recording (DWK_RECORD=<file> on the device) against
+// the dashboard in an offscreen KindleWindow. A VirtualClock starts at the
+// recorded wall time, so every timer fires exactly as it did, with the
+// recorded taps and data pushes in between. Reports widget renders, the
+// area sent for refresh and the CPU time used, so a field trace becomes a
+// regression benchmark.
+//
+// Usage: dynamic-widget-replay <log> [layout] [--realtime]
+// Without --realtime the log runs as fast as possible. The layout must be
+// the one the log was recorded with (widgets are matched by position);
+// without one the built-in dashboard is used. As for the soak test, GTK
+// needs a display (xvfb-run on a headless box).
+#include <gtk/gtk.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <map>
+#include <string>
+#include "Clock.h"
+#include "KindleWindow.h"
+#include "Dashboard.h"
+#include "BuiltinWidgets.h"
+#include "StatsServer.h"
+#include "UpdateLog.h"
+
+static const int SCREEN_W = 1448 / 2;
+static const int SCREEN_H = 1072 / 2;
+static const int64_t TAIL_US = 5 * 1000000; // let the last animations finish
+
+static VirtualClock *vclock;
+static bool realtime = false;
+static int64_t real_start_us;
+
+static int64_t real_now_us()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<int64_t>(ts.tv_sec) * 1000000 + ts.tv_nsec / 1000;
+}
+
+static double cpu_seconds()
+{
+    struct rusage ru;
+    getrusage(RUSAGE_SELF, &ru);
+    return ru.ru_utime.tv_sec + ru.ru_stime.tv_sec + (ru.ru_utime.tv_usec + ru.ru_stime.tv_usec) / 1e6;
+}
+
+// Run everything GTK has queued (idle construction, redraws, flushes)
+static void pump()
+{
+    while (gtk_events_pending())
+        gtk_main_iteration_do(FALSE);
+}
+
+// Move the virtual clock to `target`, one timer at a time; in real time,
+// wait for each step's moment first
+static void run_until(int64_t target)
+{
+    int64_t due;
+    while ((due = vclock->next_due_us()) >= 0 && due <= target)
+    {
+        if (realtime)
+        {
+            int64_t wait = real_start_us + due - real_now_us();
+            if (wait > 0)
+                usleep(static_cast<useconds_t>(wait));
+        }
+        vclock->advance(due - vclock->monotonic_us());
+        pump();
+    }
+    if (realtime)
+    {
+        int64_t wait = real_start_us + target - real_now_us();
+        if (wait > 0)
+            usleep(static_cast<useconds_t>(wait));
+    }
+    vclock->advance(target - vclock->monotonic_us());
+    pump();
+}
+
+static void press(ModularWidget *w, const UpdateLogInput &in)
+{
+    GtkWidget *widget = w->gtkWidget;
+    if (!widget->window)
+        return;
+    int ox, oy;
+    gdk_window_get_origin(widget->window, &ox, &oy);
+
+    GdkEvent *ev = gdk_event_new(GDK_BUTTON_PRESS);
+    ev->button.window = GDK_WINDOW(g_object_ref(widget->window));
+    ev->button.send_event = TRUE;
+    ev->button.time = GDK_CURRENT_TIME;
+    ev->button.x = in.x;
+    ev->button.y = in.y;
+    ev->button.x_root = ox + in.x;
+    ev->button.y_root = oy + in.y;
+    ev->button.button = in.button;
+    gtk_widget_event(widget, ev);
+    gdk_event_free(ev);
+}
+
+int main(int argc, char *argv[])
+{
+    const char *log_path = nullptr;
+    const char *layout_path = nullptr;
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--realtime") == 0)
+            realtime = true;
+        else if (!log_path)
+            log_path = argv[i];
+        else
+            layout_path = argv[i];
+    }
+    if (!log_path)
+    {
+        fprintf(stderr, "usage: %s <log> [layout] [--realtime]\n", argv[0]);
+        return 2;
+    }
+
+    UpdateLogReader log;
+    if (!log.open(log_path))
+    {
+        fprintf(stderr, "%s: not an update log\n", log_path);
+        return 1;
+    }
+
+    VirtualClock clock(static_cast<time_t>(log.start_wall_ms / 1000));
+    Clock::get() = vclock = &clock;
+
+    gtk_init(&argc, &argv);
+
+    KindleWindow kw(SCREEN_W, SCREEN_H, true);
+    register_builtin_widgets();
+    if (!layout_path || !kw.load_layout(layout_path))
+        build_dashboard(kw);
+    kw.show_all();
+    pump();
+
+    // Recorded widget keys -> live widgets
+    std::map<uint32_t, ModularWidget *> by_key;
+    for (ModularWidget *w : ModularWidget::instances())
+        by_key[w->state_key()] = w;
+
+    // Construction is not part of the measurement
+    uint64_t renders_start = 0, area_start = 0;
+    for (ModularWidget *w : ModularWidget::instances())
+    {
+        renders_start += w->stats.expose_calls;
+        area_start += w->stats.invalidated_bytes;
+    }
+    uint64_t wakeups_start = clock.dispatched;
+    double cpu_start = cpu_seconds();
+    real_start_us = real_now_us();
+    uint64_t replayed = 0, skipped = 0;
+    int64_t last_us = 0;
+
+    UpdateLogEntry e;
+    while (log.next(e))
+    {
+        last_us = static_cast<int64_t>(e.t_ms) * 1000;
+        run_until(last_us);
+
+        auto it = by_key.find(e.widget);
+        if (it == by_key.end())
+        {
+            skipped++; // not in this layout (or on a page that was never built)
+            continue;
+        }
+        if (e.kind == UPDATE_INPUT)
+            press(it->second, e.input);
+        else if (e.kind == UPDATE_DATA)
+        {
+            std::vector<const char *> keys, values;
+            for (size_t i = 0; i < e.keys.size(); i++)
+            {
+                keys.push_back(e.keys[i].c_str());
+                values.push_back(e.values[i].c_str());
+            }
+            it->second->on_data(keys.data(), values.data(), static_cast<int>(keys.size()));
+        }
+        replayed++;
+        pump();
+    }
+    run_until(last_us + TAIL_US);
+
+    double cpu = cpu_seconds() - cpu_start;
+    double wall = (real_now_us() - real_start_us) / 1e6;
+    uint64_t renders = 0, area = 0;
+    for (ModularWidget *w : ModularWidget::instances())
+    {
+        renders += w->stats.expose_calls;
+        area += w->stats.invalidated_bytes;
+    }
+
+    printf("%s", StatsServer::report().c_str());
+    printf("\nreplayed %llu events (%llu skipped) over %.1f s recorded in %.2f s\n",
+           static_cast<unsigned long long>(replayed), static_cast<unsigned long long>(skipped),
+           (last_us + TAIL_US) / 1e6, wall);
+    printf("renders %llu, refresh area %llu kpx, timer wakeups %llu, cpu %.3f s\n",
+           static_cast<unsigned long long>(renders - renders_start),
+           static_cast<unsigned long long>((area - area_start) / 1000),
+           static_cast<unsigned long long>(clock.dispatched - wakeups_start), cpu);
+    return 0;
+}
@@ -0,0 +1,109 @@
+// Accelerated soak test: runs the full dashboard in an offscreen KindleWindow
+// under a VirtualClock, jumping straight from one timer to the next, so days
+// of operation take minutes. Reports RSS growth, timer wakeups and widget
+// refreshes per simulated hour.
+//
+// Usage: dynamic-widget-soak [days=7] [report_every_hours=24]
+// GTK still needs a display connection; on a headless box run it under
+// xvfb-run. Plugin widgets load from $DWK_PLUGIN_DIR (the build directory).
+#include <gtk/gtk.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include "Clock.h"
+#include "KindleWindow.h"
+#include "Dashboard.h"
+#include "BuiltinWidgets.h"
+
+static const int SCREEN_W = 1448 / 2;
+static const int SCREEN_H = 1072 / 2;
+static const int64_t HOUR_US = 3600LL * 1000000;
+
+static long rss_kb()
+{
+    long size = 0, resident = 0;
+    FILE *f = fopen("/proc/self/statm", "r");
+    if (f)
+    {
+        if (fscanf(f, "%ld %ld", &size, &resident) != 2)
+            resident = 0;
+        fclose(f);
+    }
+    return resident * (sysconf(_SC_PAGESIZE) / 1024);
+}
+
+static uint64_t total_exposes()
+{
+    uint64_t n = 0;
+    for (ModularWidget *w : ModularWidget::instances())
+        n += w->stats.expose_calls;
+    return n;
+}
+
+// Run everything GTK has queued (idle construction, redraws, flushes)
+static void pump()
+{
+    while (gtk_events_pending())
+        gtk_main_iteration_do(FALSE);
+}
+
+int main(int argc, char *argv[])
+{
+    double days = argc > 1 ? atof(argv[1]) : 7.0;
+    int report_every = argc > 2 ? atoi(argv[2]) : 24;
+    if (report_every < 1)
+        report_every = 1;
+
+    VirtualClock clock;
+    Clock::get() = &clock;
+
+    gtk_init(&argc, &argv);
+
+    KindleWindow kw(SCREEN_W, SCREEN_H, true);
+    register_builtin_widgets();
+    build_dashboard(kw);
+    kw.show_all();
+    pump();
+
+    int hours = static_cast<int>(days * 24);
+    long rss_start = rss_kb();
+    uint64_t wakeups_mark = clock.dispatched;
+    uint64_t exposes_mark = total_exposes();
+    struct timespec t0, t1;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+
+    printf("%6s %10s %12s %12s\n", "hour", "rss_kb", "wakeups/h", "refreshes/h");
+    for (int hour = 1; hour <= hours; hour++)
+    {
+        int64_t hour_end = hour * HOUR_US;
+        int64_t due;
+        while ((due = clock.next_due_us()) >= 0 && due <= hour_end)
+        {
+            clock.advance(due - clock.monotonic_us());
+            pump();
+        }
+        clock.advance(hour_end - clock.monotonic_us());
+        pump();
+
+        if (hour % report_every == 0 || hour == hours)
+        {
+            int span = hour % report_every ? hour % report_every : report_every;
+            printf("%6d %10ld %12.1f %12.1f\n", hour, rss_kb(),
+                   double(clock.dispatched - wakeups_mark) / span,
+                   double(total_exposes() - exposes_mark) / span);
+            wakeups_mark = clock.dispatched;
+            exposes_mark = total_exposes();
+        }
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    long rss_end = rss_kb();
+    printf("\nsimulated %d h in %.1f s\n", hours,
+           (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) / 1e9);
+    printf("rss: start %ld kB, end %ld kB, growth %ld kB\n", rss_start, rss_end, rss_end - rss_start);
+    printf("total timer wakeups %llu, widget refreshes %llu\n",
+           static_cast<unsigned long long>(clock.dispatched),
+           static_cast<unsigned long long>(total_exposes()));
+    return 0;
+}